@@ -0,0 +1,599 @@
+#include "compact_linked_list.h"
+#include "compact_list.h"
+#include "compact_list_pool.h"
+#include "compact_sorted_list.h"
+#include "compact_vector.h"
+#include "dynamic_compact_forward_list.h"
+
+#include <algorithm>
+#include <chrono>
+#include <forward_list>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+template <typename F>
+void measure(const std::string& name, const size_t operation_count, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    const unsigned long long checksum = f();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    std::cout << std::setw(48) << name << std::setw(10) << std::fixed << std::setprecision(2) << seconds*1e9/operation_count << " ns/op  (checksum " << checksum << ")" << std::endl;
+}
+
+template <size_t value_limit, size_t max_size>
+void benchmark_list(const size_t repetitions) {
+    using list_type = compact_forward_list<value_limit, max_size>;
+    const std::string name = "<" + std::to_string(value_limit) + ", " + std::to_string(max_size) + "> ";
+    auto list = std::make_unique<list_type>();
+
+    measure(name + "push_front + pop_front", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(size_t i = 0; i < max_size; i++) {
+                list->push_front(i % value_limit);
+            }
+            for(size_t i = 0; i < max_size; i++) {
+                checksum += *list->begin();
+                list->pop_front();
+            }
+        }
+        return checksum;
+    });
+
+    measure(name + "push_back to max size", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            list->clear();
+            for(size_t i = 0; i < max_size; i++) {
+                list->push_back(i % value_limit);
+            }
+            checksum += *list->begin();
+        }
+        return checksum;
+    });
+
+    measure(name + "iteration", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(const auto value : *list) {
+                checksum += value;
+            }
+        }
+        return checksum;
+    });
+}
+
+// The same operations on a list sized at run time, next to the compile-time numbers above
+template <size_t value_limit, size_t max_size>
+void benchmark_dynamic_list(const size_t repetitions) {
+    const std::string name = "<" + std::to_string(value_limit) + ", " + std::to_string(max_size) + "> dynamic ";
+    dynamic_compact_forward_list list(value_limit, max_size);
+
+    measure(name + "push_front + pop_front", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(size_t i = 0; i < max_size; i++) {
+                list.push_front(i % value_limit);
+            }
+            for(size_t i = 0; i < max_size; i++) {
+                checksum += list.front();
+                list.pop_front();
+            }
+        }
+        return checksum;
+    });
+
+    measure(name + "push_back to max size", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            list.clear();
+            for(size_t i = 0; i < max_size; i++) {
+                list.push_back(i % value_limit);
+            }
+            checksum += list.front();
+        }
+        return checksum;
+    });
+
+    measure(name + "iteration", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(const auto value : std::as_const(list)) {
+                checksum += value;
+            }
+        }
+        return checksum;
+    });
+
+    measure(name + "for_each", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            list.for_each([&](const auto value){ checksum += value; });
+        }
+        return checksum;
+    });
+}
+
+template <size_t value_limit, size_t max_size, template <size_t, size_t, size_t> class layout_policy>
+void benchmark_layout(const std::string& layout_name, const size_t repetitions) {
+    using list_type = compact_forward_list<value_limit, max_size, heap_storage, layout_policy>;
+    const std::string name = "<" + std::to_string(value_limit) + ", " + std::to_string(max_size) + "> " + layout_name + " ";
+    auto list = std::make_unique<list_type>();
+    std::cout << std::setw(48) << name + "buffer" << std::setw(10) << list_type::required_bytes << " bytes" << std::endl;
+
+    measure(name + "push_front + pop_front", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(size_t i = 0; i < max_size; i++) {
+                list->push_front(i % value_limit);
+            }
+            for(size_t i = 0; i < max_size; i++) {
+                checksum += *list->begin();
+                list->pop_front();
+            }
+        }
+        return checksum;
+    });
+
+    std::mt19937_64 gen(7);
+    for(size_t i = 0; i < max_size; i++) {
+        list->push_front(gen() % value_limit);
+    }
+    list->sort();
+    measure(name + "iteration scattered", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(const auto value : *list) {
+                checksum += value;
+            }
+        }
+        return checksum;
+    });
+    list->compact();
+    measure(name + "for_each compacted", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            list->for_each([&](const auto value){ checksum += value; });
+        }
+        return checksum;
+    });
+}
+
+// Every layout for one pair of limits, and the one auto_layout picks
+template <size_t value_limit, size_t max_size>
+void benchmark_layouts(const size_t repetitions) {
+    constexpr size_t value_bits = std::bit_width(value_limit-1);
+    constexpr size_t count_bits = std::bit_width(max_size);
+    using chosen = auto_layout<value_bits, count_bits, max_size>;
+    const std::string chosen_name = std::is_base_of_v<interleaved_layout<value_bits, count_bits, max_size>, chosen> ? "interleaved"
+                                  : std::is_base_of_v<planar_layout<value_bits, count_bits, max_size>, chosen> ? "planar" : "padded";
+    std::cout << std::endl << "<" << value_limit << ", " << max_size << "> auto_layout picks " << chosen_name << std::endl;
+    benchmark_layout<value_limit, max_size, interleaved_layout>("interleaved", repetitions);
+    benchmark_layout<value_limit, max_size, planar_layout>("planar", repetitions);
+    benchmark_layout<value_limit, max_size, padded_layout>("padded", repetitions);
+}
+
+// Bulk operations on size random values, each repetition starts from the same unsorted contents
+template <size_t value_limit, size_t size>
+void benchmark_bulk(const size_t repetitions) {
+    using list_type = compact_forward_list<value_limit, 2*size>;
+    const std::string name = "<" + std::to_string(value_limit) + ", " + std::to_string(size) + "> ";
+    std::mt19937_64 gen(2);
+    std::vector<uint64_t> values(size);
+    for(auto& value : values) {
+        value = gen() % value_limit;
+    }
+    std::vector<uint64_t> sorted_values = values;
+    std::sort(std::begin(sorted_values), std::end(sorted_values));
+
+    auto list = std::make_unique<list_type>();
+    auto other = std::make_unique<list_type>();
+    std::forward_list<uint64_t> forward_list;
+    std::forward_list<uint64_t> other_forward_list;
+
+    auto run_both = [&](const std::string& operation, auto&& prepare, auto&& compact_operation, auto&& forward_operation) {
+        measure(name + operation + " compact", repetitions*size, [&]{
+            unsigned long long checksum = 0;
+            for(size_t r = 0; r < repetitions; r++) {
+                prepare();
+                compact_operation();
+                checksum += *list->begin();
+            }
+            return checksum;
+        });
+        measure(name + operation + " std::forward_list", repetitions*size, [&]{
+            unsigned long long checksum = 0;
+            for(size_t r = 0; r < repetitions; r++) {
+                prepare();
+                forward_operation();
+                checksum += forward_list.front();
+            }
+            return checksum;
+        });
+    };
+
+    auto assign_unsorted = [&]{
+        list->assign(values);
+        forward_list.assign(std::begin(values), std::end(values));
+    };
+    run_both("assign", []{}, [&]{ list->assign(values); }, [&]{ forward_list.assign(std::begin(values), std::end(values)); });
+    run_both("sort", assign_unsorted, [&]{ list->sort(); }, [&]{ forward_list.sort(); });
+    run_both("reverse", assign_unsorted, [&]{ list->reverse(); }, [&]{ forward_list.reverse(); });
+    run_both("remove_if", assign_unsorted,
+        [&]{ list->remove_if([](const auto value){ return value % 2; }); },
+        [&]{ forward_list.remove_if([](const auto value){ return value % 2; }); });
+    run_both("merge", [&]{
+            list->assign(sorted_values);
+            other->assign(sorted_values);
+            forward_list.assign(std::begin(sorted_values), std::end(sorted_values));
+            other_forward_list.assign(std::begin(sorted_values), std::end(sorted_values));
+        },
+        [&]{ list->merge(*other); list->unique(); },
+        [&]{ forward_list.merge(other_forward_list); forward_list.unique(); });
+}
+
+// Iteration over a list whose links are scattered by sort, before and after compact
+template <size_t value_limit, size_t size>
+void benchmark_compaction(const size_t repetitions) {
+    using list_type = compact_forward_list<value_limit, size>;
+    const std::string name = "<" + std::to_string(value_limit) + ", " + std::to_string(size) + "> ";
+    std::mt19937_64 gen(3);
+    auto list = std::make_unique<list_type>();
+    for(size_t i = 0; i < size; i++) {
+        list->push_front(gen() % value_limit);
+    }
+    list->sort();
+
+    auto iterate = [&](const std::string& state) {
+        measure(name + "iteration " + state, repetitions*size, [&]{
+            unsigned long long checksum = 0;
+            for(size_t r = 0; r < repetitions; r++) {
+                for(const auto value : *list) {
+                    checksum += value;
+                }
+            }
+            return checksum;
+        });
+        measure(name + "for_each " + state, repetitions*size, [&]{
+            unsigned long long checksum = 0;
+            for(size_t r = 0; r < repetitions; r++) {
+                list->for_each([&](const auto value){ checksum += value; });
+            }
+            return checksum;
+        });
+    };
+    iterate("scattered");
+    measure(name + "compact", size, [&]{
+        list->compact();
+        return *list->begin();
+    });
+    iterate("compacted");
+}
+
+// Bulk conversion between compact_vector and a uint32_t buffer against one element at a time
+template <size_t value_limit, size_t size>
+void benchmark_vector(const size_t repetitions) {
+    using vector_type = compact_vector<value_limit, size>;
+    const std::string name = "<" + std::to_string(value_limit) + ", " + std::to_string(size) + "> vector ";
+    std::mt19937 gen(5);
+    std::vector<uint32_t> values(size);
+    for(auto& value : values) {
+        value = gen() % value_limit;
+    }
+    auto vector = std::make_unique<vector_type>();
+
+    measure(name + "push_back", repetitions*size, [&]{
+        for(size_t r = 0; r < repetitions; r++) {
+            vector->clear();
+            for(const auto value : values) {
+                vector->push_back(value);
+            }
+        }
+        return (*vector)[size/2];
+    });
+    measure(name + "pack", repetitions*size, [&]{
+        for(size_t r = 0; r < repetitions; r++) {
+            vector->assign(values.data(), size);
+        }
+        return (*vector)[size/2];
+    });
+    measure(name + "operator[]", repetitions*size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(size_t i = 0; i < size; i++) {
+                values[i] = (*std::as_const(vector))[i];
+            }
+            checksum += values[r % size];
+        }
+        return checksum;
+    });
+    measure(name + "unpack", repetitions*size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            vector->unpack(0, size, values.data());
+            checksum += values[r % size];
+        }
+        return checksum;
+    });
+}
+
+// Doubly linked compact_list against compact_forward_list, the forward list has to find the
+// last element from the front and reverses itself twice to iterate backwards
+template <size_t value_limit, size_t max_size>
+void benchmark_xor_list(const size_t repetitions) {
+    using xor_type = compact_list<value_limit, max_size>;
+    using list_type = compact_forward_list<value_limit, max_size>;
+    const std::string name = "<" + std::to_string(value_limit) + ", " + std::to_string(max_size) + "> ";
+    auto xor_list = std::make_unique<xor_type>();
+    auto list = std::make_unique<list_type>();
+    for(size_t i = 0; i < max_size; i++) {
+        xor_list->push_back(i % value_limit);
+        list->push_back(i % value_limit);
+    }
+
+    measure(name + "xor iterate", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(const auto value : std::as_const(*xor_list)) {
+                checksum += value;
+            }
+        }
+        return checksum;
+    });
+    measure(name + "forward iterate", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(const auto value : std::as_const(*list)) {
+                checksum += value;
+            }
+        }
+        return checksum;
+    });
+    measure(name + "xor reverse iterate", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(auto it = xor_list->rbegin(); it != xor_list->rend(); ++it) {
+                checksum += *it;
+            }
+        }
+        return checksum;
+    });
+    measure(name + "forward reverse iterate", repetitions*max_size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            list->reverse();
+            for(const auto value : std::as_const(*list)) {
+                checksum += value;
+            }
+            list->reverse();
+        }
+        return checksum;
+    });
+    //Rotates the list by moving the last element to the front, O(max_size) per rotation for the forward list
+    const size_t rotations = repetitions*max_size/10;
+    measure(name + "xor pop_back + push_front", rotations, [&]{
+        for(size_t r = 0; r < rotations; r++) {
+            const auto value = xor_list->back();
+            xor_list->pop_back();
+            xor_list->push_front(value);
+        }
+        return xor_list->front();
+    });
+    measure(name + "forward erase last + push_front", rotations/100, [&]{
+        for(size_t r = 0; r < rotations/100; r++) {
+            auto before_last = list->before_begin();
+            for(auto next = list->begin(); std::next(next) != list->end(); ++next) {
+                before_last = next;
+            }
+            const auto value = *std::next(before_last);
+            list->erase_after(before_last);
+            list->push_front(value);
+        }
+        return *list->begin();
+    });
+    //Erases every other element while walking and refills the gaps
+    measure(name + "xor erase + insert at iterator", repetitions*max_size, [&]{
+        for(size_t r = 0; r < repetitions; r++) {
+            for(auto it = xor_list->begin(); it != xor_list->end();) {
+                const auto value = *it;
+                it = xor_list->erase(it);
+                it = std::next(xor_list->insert(it, value));
+            }
+        }
+        return xor_list->front();
+    });
+    measure(name + "forward erase + insert after", repetitions*max_size, [&]{
+        for(size_t r = 0; r < repetitions; r++) {
+            for(auto it = list->before_begin(); std::next(it) != list->end();) {
+                const auto value = *std::next(it);
+                list->erase_after(it);
+                it = list->insert_after(it, value);
+            }
+        }
+        return *list->begin();
+    });
+}
+
+// Sorted ids in compact_sorted_list against a compact_forward_list kept in order
+template <size_t value_limit, size_t size>
+void benchmark_sorted(const size_t repetitions) {
+    using sorted_type = compact_sorted_list<value_limit, size>;
+    using list_type = compact_forward_list<value_limit, size>;
+    const std::string name = "<" + std::to_string(value_limit) + ", " + std::to_string(size) + "> ";
+    std::cout << name << sorted_type::required_bytes << " bytes sorted, " << list_type::required_bytes << " bytes list" << std::endl;
+    std::mt19937_64 gen(6);
+    std::vector<uint64_t> values(size);
+    for(auto& value : values) {
+        value = gen() % value_limit;
+    }
+    auto sorted = std::make_unique<sorted_type>();
+    auto list = std::make_unique<list_type>();
+
+    measure(name + "sorted insert", repetitions*size, [&]{
+        for(size_t r = 0; r < repetitions; r++) {
+            sorted->clear();
+            for(const auto value : values) {
+                sorted->insert(value);
+            }
+        }
+        return sorted->size();
+    });
+    measure(name + "list ordered insert", repetitions*size, [&]{
+        for(size_t r = 0; r < repetitions; r++) {
+            list->clear();
+            for(const auto value : values) {
+                auto position = list->before_begin();
+                for(auto next = std::next(position); next != list->end() && *next < value; ++next) {
+                    position = next;
+                }
+                list->insert_after(position, value);
+            }
+        }
+        return *list->begin();
+    });
+    measure(name + "sorted contains", repetitions*size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(const auto value : values) {
+                checksum += sorted->contains(value ^ r);
+            }
+        }
+        return checksum;
+    });
+    measure(name + "sorted iterate", repetitions*size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            for(const auto value : *sorted) {
+                checksum += value;
+            }
+        }
+        return checksum;
+    });
+    measure(name + "sorted for_each", repetitions*size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            sorted->for_each([&](const auto value) { checksum += value; });
+        }
+        return checksum;
+    });
+    measure(name + "list for_each", repetitions*size, [&]{
+        unsigned long long checksum = 0;
+        for(size_t r = 0; r < repetitions; r++) {
+            list->for_each([&](const auto value) { checksum += value; });
+        }
+        return checksum;
+    });
+}
+
+// Counts heap bytes including the allocator's rounding (glibc malloc_usable_size), not its per-chunk header
+size_t allocated_bytes = 0;
+
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept {}
+
+    T* allocate(const size_t count) {
+        T* pointer = static_cast<T*>(malloc(count*sizeof(T)));
+        allocated_bytes += malloc_usable_size(pointer);
+        return pointer;
+    }
+
+    void deallocate(T* pointer, size_t) noexcept {
+        allocated_bytes -= malloc_usable_size(pointer);
+        free(pointer);
+    }
+
+    bool operator==(const counting_allocator&) const noexcept = default;
+};
+
+// Thousands of small bounded lists (buckets) holding node_count values in total
+void benchmark_pool() {
+    constexpr size_t value_limit = 1024;
+    constexpr size_t bucket_count = 4096;
+    constexpr size_t node_count = 65536;
+    constexpr size_t bucket_capacity = 64;
+
+    std::mt19937 gen(1);
+    std::vector<std::pair<size_t, size_t>> pushes(node_count);
+    std::vector<size_t> bucket_sizes(bucket_count);
+    for(auto& [bucket, value] : pushes) {
+        do {
+            bucket = gen() % bucket_count;
+        } while(bucket_sizes[bucket] == bucket_capacity);
+        bucket_sizes[bucket]++;
+        value = gen() % value_limit;
+    }
+
+    auto pool = std::make_unique<compact_list_pool<value_limit, node_count, bucket_count>>();
+    measure("pool push_front", node_count, [&]{
+        for(const auto& [bucket, value] : pushes) {
+            pool->push_front(bucket, value);
+        }
+        return pool->front(0);
+    });
+    measure("pool splice_front", node_count, [&]{
+        for(const auto& [bucket, value] : pushes) {
+            pool->splice_front((bucket+1) % bucket_count, bucket);
+        }
+        return pool->front(0);
+    });
+
+    using bucket_list = compact_forward_list<value_limit, bucket_capacity>;
+    std::vector<bucket_list> compact_lists(bucket_count);
+    for(const auto& [bucket, value] : pushes) {
+        compact_lists[bucket].push_front(value);
+    }
+
+    allocated_bytes = 0;
+    {
+        std::vector<std::forward_list<uint16_t, counting_allocator<uint16_t>>> lists(bucket_count);
+        for(const auto& [bucket, value] : pushes) {
+            lists[bucket].push_front(value);
+        }
+        allocated_bytes += bucket_count*sizeof(lists[0]);
+        std::cout << std::endl << bucket_count << " lists, " << node_count << " values < " << value_limit << " in total, at most " << bucket_capacity << " per list" << std::endl;
+        std::cout << std::setw(48) << "compact_list_pool" << std::setw(10) << sizeof(*pool) + decltype(pool)::element_type::required_bytes << " bytes" << std::endl;
+        std::cout << std::setw(48) << "vector<compact_forward_list>" << std::setw(10) << bucket_count*(sizeof(bucket_list) + bucket_list::required_bytes) << " bytes" << std::endl;
+        std::cout << std::setw(48) << "vector<forward_list>" << std::setw(10) << allocated_bytes << " bytes (+ malloc headers)" << std::endl;
+    }
+}
+
+int main() {
+    benchmark_list<2, 1000>(1000);
+    benchmark_list<42, 1000>(1000);
+    benchmark_list<1000, 1000>(1000);
+    benchmark_list<(1ull << 20), 4000>(250);
+    benchmark_list<(1ull << 40), 4000>(250);
+    benchmark_dynamic_list<2, 1000>(1000);
+    benchmark_dynamic_list<42, 1000>(1000);
+    benchmark_dynamic_list<1000, 1000>(1000);
+    benchmark_dynamic_list<(1ull << 20), 4000>(250);
+    benchmark_dynamic_list<(1ull << 40), 4000>(250);
+    benchmark_bulk<1000, 1000>(200);
+    benchmark_bulk<(1ull << 20), 30000>(10);
+    benchmark_compaction<1000, (1 << 16)>(20);
+    benchmark_compaction<(1ull << 20), (1 << 20)>(5);
+    benchmark_vector<2, (1 << 16)>(200);
+    benchmark_vector<1000, (1 << 16)>(200);
+    benchmark_vector<(1 << 20), (1 << 16)>(200);
+    benchmark_xor_list<1000, 1000>(1000);
+    benchmark_xor_list<(1ull << 20), 4000>(250);
+    benchmark_sorted<(1 << 16), 4000>(20);
+    benchmark_sorted<(1ull << 32), 4000>(20);
+    benchmark_layouts<1000, 1000>(1000);
+    benchmark_layouts<256, 255>(1000);
+    benchmark_layouts<(1 << 16), 4000>(250);
+    benchmark_layouts<(1 << 20), 4000>(250);
+    benchmark_layouts<(1 << 20), (1 << 20)>(2);
+    benchmark_pool();
+    return 0;
+}
@@ -1,22 +1,359 @@
+#pragma once
+
 #include <cstddef>
 #include <cmath>
 #include <bit>
 #include <type_traits>
 #include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 template <size_t bit_count>
 using smallest_usigned_type_with_bits = std::conditional_t<bit_count <= 8, uint8_t, std::conditional_t<bit_count <= 16, uint16_t, std::conditional_t<bit_count <= 32, uint32_t, uint64_t>>>;
 
-template<size_t value_limit, size_t max_size>
+namespace compact_detail {
+    template <size_t bit_count>
+    constexpr uint64_t low_bits_mask = bit_count >= 64 ? ~uint64_t{0} : (uint64_t{1} << bit_count) - 1;
+
+    // Little-endian load of the 8 bytes at data
+    inline uint64_t load_full_word(const std::byte* data) noexcept {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big) {
+            word = __builtin_bswap64(word);
+        }
+        return word;
+    }
+
+    // Little-endian load of up to 8 bytes starting at byte_position, bytes past byte_size read as 0
+    inline uint64_t load_word(const std::byte* data, const size_t byte_size, const size_t byte_position) noexcept {
+        uint64_t word = 0;
+        if (byte_position + sizeof(word) <= byte_size) {
+            word = load_full_word(data + byte_position);
+        } else {
+            for(size_t i = byte_position; i < byte_size; i++) {
+                word |= uint64_t(data[i]) << (8*(i-byte_position));
+            }
+        }
+        return word;
+    }
+
+    // Counterpart of load_word, bytes past byte_size are not written
+    inline void store_word(std::byte* data, const size_t byte_size, const size_t byte_position, uint64_t word) noexcept {
+        if (byte_position + sizeof(word) <= byte_size) {
+            if constexpr (std::endian::native == std::endian::big) {
+                word = __builtin_bswap64(word);
+            }
+            std::memcpy(data + byte_position, &word, sizeof(word));
+        } else {
+            for(size_t i = byte_position; i < byte_size; i++) {
+                data[i] = std::byte(word >> (8*(i-byte_position)));
+            }
+        }
+    }
+
+    // Reads bit_count bits at bit_position with one unaligned word load. A field of more than
+    // 57 bits can straddle 9 bytes, its top bits then come from the following byte.
+    template <size_t bit_count, class T>
+    T load_bits(const std::byte* data, const size_t byte_size, const size_t bit_position) noexcept {
+        if constexpr (bit_count == 0) {
+            return 0;
+        } else {
+            const size_t byte_position = bit_position/8;
+            const size_t shift = bit_position%8;
+            uint64_t result = load_word(data, byte_size, byte_position) >> shift;
+            if constexpr (bit_count > 57) {
+                if (shift + bit_count > 64) {
+                    result |= uint64_t(data[byte_position+8]) << (64-shift);
+                }
+            }
+            return T(result & low_bits_mask<bit_count>);
+        }
+    }
+
+    template <size_t bit_count, class T>
+    void store_bits(std::byte* data, const size_t byte_size, const size_t bit_position, const T value) noexcept {
+        if constexpr (bit_count > 0) {
+            const size_t byte_position = bit_position/8;
+            const size_t shift = bit_position%8;
+            const uint64_t mask = low_bits_mask<bit_count> << shift;
+            const uint64_t word = load_word(data, byte_size, byte_position);
+            store_word(data, byte_size, byte_position, (word & ~mask) | ((uint64_t(value) << shift) & mask));
+            if constexpr (bit_count > 57) {
+                if (shift + bit_count > 64) {
+                    const std::byte high_mask = std::byte(low_bits_mask<bit_count> >> (64-shift));
+                    std::byte& target = data[byte_position+8];
+                    target = (target & ~high_mask) | (std::byte(uint64_t(value) >> (64-shift)) & high_mask);
+                }
+            }
+        }
+    }
+
+    // Same as load_bits and store_bits with the width known only at run time
+    inline uint64_t load_bits(const std::byte* data, const size_t byte_size, const size_t bit_position, const size_t bit_count) noexcept {
+        if (bit_count == 0) {
+            return 0;
+        }
+        const size_t byte_position = bit_position/8;
+        const size_t shift = bit_position%8;
+        uint64_t result = load_word(data, byte_size, byte_position) >> shift;
+        if (shift + bit_count > 64) {
+            result |= uint64_t(data[byte_position+8]) << (64-shift);
+        }
+        return result & (bit_count >= 64 ? ~uint64_t{0} : (uint64_t{1} << bit_count) - 1);
+    }
+
+    inline void store_bits(std::byte* data, const size_t byte_size, const size_t bit_position, const size_t bit_count, const uint64_t value) noexcept {
+        if (bit_count == 0) {
+            return;
+        }
+        const size_t byte_position = bit_position/8;
+        const size_t shift = bit_position%8;
+        const uint64_t field_mask = bit_count >= 64 ? ~uint64_t{0} : (uint64_t{1} << bit_count) - 1;
+        const uint64_t mask = field_mask << shift;
+        const uint64_t word = load_word(data, byte_size, byte_position);
+        store_word(data, byte_size, byte_position, (word & ~mask) | ((value << shift) & mask));
+        if (shift + bit_count > 64) {
+            const std::byte high_mask = std::byte(field_mask >> (64-shift));
+            std::byte& target = data[byte_position+8];
+            target = (target & ~high_mask) | (std::byte(value >> (64-shift)) & high_mask);
+        }
+    }
+}
+
+// Storage policies of compact_forward_list, each owns or refers to byte_size bytes. Owned bytes
+// start zeroed, so bits of never used nodes cannot leak old heap or stack contents into serialize.
+template <size_t byte_size>
+class heap_storage {
+    std::unique_ptr<std::byte[]> data;
+
+public:
+    heap_storage() : data(new std::byte[byte_size]()) {
+    }
+
+    heap_storage(const heap_storage& other) : heap_storage() {
+        std::copy(other.bytes(), other.bytes()+byte_size, bytes());
+    }
+
+    heap_storage& operator=(const heap_storage& other) {
+        std::copy(other.bytes(), other.bytes()+byte_size, bytes());
+        return *this;
+    }
+
+    // The source of a move gets a new zeroed buffer, which the list then clears. Move assignment
+    // swaps, the source keeps the previous list of the target.
+    heap_storage(heap_storage&& other) : data(std::exchange(other.data, std::unique_ptr<std::byte[]>(new std::byte[byte_size]()))) {
+    }
+
+    heap_storage& operator=(heap_storage&& other) noexcept {
+        std::swap(data, other.data);
+        return *this;
+    }
+
+    std::byte* bytes() noexcept { return data.get(); }
+    const std::byte* bytes() const noexcept { return data.get(); }
+};
+
+// The whole list lives inside the object, no allocation at all
+template <size_t byte_size>
+class inline_storage {
+    std::array<std::byte, byte_size> data{};
+
+public:
+    std::byte* bytes() noexcept { return data.data(); }
+    const std::byte* bytes() const noexcept { return data.data(); }
+};
+
+// Caller-provided buffer of at least required_bytes bytes (shared memory, arena, ...). It cannot
+// be copy-constructed since there is no second buffer, copy assignment copies the contents.
+// Move construction leaves the source without a buffer, it can only be destroyed or assigned to.
+template <size_t byte_size>
+class external_storage {
+    std::byte* data;
+
+public:
+    explicit external_storage(std::byte* buffer) noexcept : data(buffer) {
+    }
+
+    external_storage(const external_storage&) = delete;
+
+    external_storage& operator=(const external_storage& other) noexcept {
+        std::copy(other.bytes(), other.bytes()+byte_size, bytes());
+        return *this;
+    }
+
+    external_storage(external_storage&& other) noexcept : data(std::exchange(other.data, nullptr)) {
+    }
+
+    external_storage& operator=(external_storage&& other) noexcept {
+        std::swap(data, other.data);
+        return *this;
+    }
+
+    std::byte* bytes() noexcept { return data; }
+    const std::byte* bytes() const noexcept { return data; }
+};
+
+// Layout policies of compact_forward_list - where the free, tail and first index and the value
+// and next index of nodes 1..max_size are. The free index is at bit 0 and the tail index follows,
+// index_position(0) is the first index. layout_id tells the layouts apart in serialized buffers.
+
+// Nodes as (value, next index) one after another, the smallest layout
+template <size_t value_bits, size_t count_bits, size_t max_size>
+struct interleaved_layout {
+    constexpr static uint8_t layout_id = 0;
+    constexpr static bool separate_planes = false;
+    constexpr static size_t bit_size = max_size*(value_bits+count_bits)+3*count_bits;
+
+    constexpr static size_t index_position(const size_t index) {
+        return 2*count_bits + index*(value_bits+count_bits);
+    }
+
+    constexpr static size_t value_position(const size_t index) {
+        return 3*count_bits + (index-1)*(value_bits+count_bits);
+    }
+};
+
+// All next indices, then all values from the next byte boundary (structure of arrays). A plane
+// of 8, 16, 32 or 64-bit fields is byte aligned at the cost of at most 7 bits.
+template <size_t value_bits, size_t count_bits, size_t max_size>
+struct planar_layout {
+    constexpr static uint8_t layout_id = 1;
+    constexpr static bool separate_planes = true;
+    constexpr static size_t values_position = (3*count_bits + max_size*count_bits + 7)/8*8;
+    constexpr static size_t bit_size = values_position + max_size*value_bits;
+
+    constexpr static size_t index_position(const size_t index) {
+        return 2*count_bits + index*count_bits;
+    }
+
+    constexpr static size_t value_position(const size_t index) {
+        return values_position + (index-1)*value_bits;
+    }
+};
+
+// Nodes padded to a power of two bits and aligned to it, so no node straddles a word
+template <size_t value_bits, size_t count_bits, size_t max_size>
+struct padded_layout {
+    constexpr static uint8_t layout_id = 2;
+    constexpr static bool separate_planes = false;
+    constexpr static size_t node_bits = std::bit_ceil(value_bits+count_bits);
+    constexpr static size_t nodes_position = (3*count_bits + node_bits-1)/node_bits*node_bits;
+    constexpr static size_t bit_size = nodes_position + max_size*node_bits;
+
+    constexpr static size_t index_position(const size_t index) {
+        return index == 0 ? 2*count_bits : nodes_position + (index-1)*node_bits + value_bits;
+    }
+
+    constexpr static size_t value_position(const size_t index) {
+        return nodes_position + (index-1)*node_bits;
+    }
+};
+
+namespace compact_detail {
+    // A field is aligned when it starts at a byte boundary in every node
+    template <size_t max_size, typename Position>
+    constexpr bool is_byte_aligned(Position position) {
+        return position(1) % 8 == 0 && (max_size < 2 || (position(2) - position(1)) % 8 == 0);
+    }
+
+    // Cost model in buffer bits. Every field that needs a shift to be extracted adds
+    // misaligned_field_cost bits per node. Separate planes put a node on two cache lines, which adds
+    // split_node_cost bits per node while the buffer fits in cache. Past large_buffer_bytes,
+    // following links mostly misses the cache, and the dense index plane saves the value bits.
+    constexpr size_t misaligned_field_cost = 2;
+    constexpr size_t split_node_cost = 8;
+    constexpr size_t large_buffer_bytes = size_t{1} << 20;
+
+    template <typename layout, size_t value_bits, size_t max_size>
+    constexpr size_t layout_cost() {
+        const size_t misaligned_fields = !is_byte_aligned<max_size>(layout::value_position) + !is_byte_aligned<max_size>(layout::index_position);
+        size_t cost = layout::bit_size + max_size*misaligned_fields*misaligned_field_cost;
+        if (layout::separate_planes) {
+            cost = layout::bit_size/8 > large_buffer_bytes ? cost - max_size*value_bits : cost + max_size*split_node_cost;
+        }
+        return cost;
+    }
+
+    template <size_t value_bits, size_t count_bits, size_t max_size>
+    struct cheapest_layout {
+        using interleaved = interleaved_layout<value_bits, count_bits, max_size>;
+        using planar = planar_layout<value_bits, count_bits, max_size>;
+        using padded = padded_layout<value_bits, count_bits, max_size>;
+        constexpr static size_t interleaved_cost = layout_cost<interleaved, value_bits, max_size>();
+        constexpr static size_t planar_cost = layout_cost<planar, value_bits, max_size>();
+        constexpr static size_t padded_cost = layout_cost<padded, value_bits, max_size>();
+
+        //Ties go to interleaved, then planar, the two smallest layouts
+        using type = std::conditional_t<interleaved_cost <= planar_cost && interleaved_cost <= padded_cost, interleaved,
+                     std::conditional_t<planar_cost <= padded_cost, planar, padded>>;
+    };
+}
+
+namespace compact_detail {
+    // A serialized list is this header followed by the buffer as is: the magic bytes, value_bits,
+    // count_bits, layout_id, a zero byte and max_size as a little-endian 64-bit word
+    constexpr size_t serialized_header_bytes = 16;
+    constexpr std::array<std::byte, 4> serialized_magic{std::byte{'C'}, std::byte{'L'}, std::byte{'L'}, std::byte{1}};
+
+    inline void store_serialized_header(std::byte* data, const size_t value_bits, const size_t count_bits, const uint8_t layout_id, const uint64_t max_size) noexcept {
+        std::copy(serialized_magic.begin(), serialized_magic.end(), data);
+        data[4] = std::byte(value_bits);
+        data[5] = std::byte(count_bits);
+        data[6] = std::byte(layout_id);
+        data[7] = std::byte{0};
+        store_word(data, serialized_header_bytes, 8, max_size);
+    }
+
+    // Throws std::invalid_argument unless buffer holds a list serialized with the same parameters
+    inline void check_serialized_header(const std::span<const std::byte> buffer, const size_t value_bits, const size_t count_bits, const uint8_t layout_id, const uint64_t max_size, const size_t byte_size) {
+        if (buffer.size() < serialized_header_bytes + byte_size) {
+            throw std::invalid_argument("compact_forward_list: serialized buffer is too small");
+        }
+        if (!std::equal(serialized_magic.begin(), serialized_magic.end(), buffer.data())) {
+            throw std::invalid_argument("compact_forward_list: buffer does not hold a serialized list");
+        }
+        if (buffer[4] != std::byte(value_bits) || buffer[5] != std::byte(count_bits) || buffer[6] != std::byte(layout_id)
+            || buffer[7] != std::byte{0} || load_word(buffer.data(), serialized_header_bytes, 8) != max_size) {
+            throw std::invalid_argument("compact_forward_list: serialized list has different value_bits, count_bits, max_size or layout");
+        }
+    }
+}
+
+// Tag of the constructor that adopts a serialized buffer in place
+struct adopt_serialized_t {
+    explicit adopt_serialized_t() = default;
+};
+inline constexpr adopt_serialized_t adopt_serialized{};
+
+// The layout with the lowest cost in compact_detail::layout_cost for the given widths
+template <size_t value_bits, size_t count_bits, size_t max_size>
+struct auto_layout : compact_detail::cheapest_layout<value_bits, count_bits, max_size>::type {
+};
+
+template<size_t value_limit, size_t max_size, template <size_t> class storage_policy = heap_storage, template <size_t, size_t, size_t> class layout_policy = interleaved_layout>
 class compact_forward_list {
 private:
     constexpr static size_t value_bits = ceil(log2(value_limit));
     constexpr static size_t count_bits = ceil(log2(max_size+1));
-    constexpr static size_t bit_size = max_size*(value_bits+count_bits)+2*count_bits;
+    using layout = layout_policy<value_bits, count_bits, max_size>;
+    constexpr static size_t bit_size = layout::bit_size;
     constexpr static size_t byte_size = (bit_size+7)/8;
-    std::byte *data;
+    storage_policy<byte_size> storage;
 
 public:
+    constexpr static size_t required_bytes = byte_size;
+    constexpr static size_t serialized_bytes = compact_detail::serialized_header_bytes + byte_size;
+
     using index_type = smallest_usigned_type_with_bits<count_bits>;
     using value_type = smallest_usigned_type_with_bits<value_bits>;
 
@@ -33,34 +370,34 @@ public:
     class iterator_base {
         friend class compact_forward_list;
         index_type index;
-        T& list;
+        T* list;
 
     public:
-        using difference_type = compact_forward_list<value_limit, max_size>::value_type;
-        using value_type = compact_forward_list<value_limit, max_size>::value_type;
-        using pointer = const compact_forward_list<value_limit, max_size>::value_type*;
-        using reference = const compact_forward_list<value_limit, max_size>::value_type&;
+        using difference_type = compact_forward_list::value_type;
+        using value_type = compact_forward_list::value_type;
+        using pointer = const compact_forward_list::value_type*;
+        using reference = const compact_forward_list::value_type&;
         using iterator_category = std::forward_iterator_tag;
 
-        iterator_base(index_type index, T& list) : index(index), list(list) {
+        iterator_base(index_type index, T& list) : index(index), list(&list) {
         }
 
-        auto operator*(){
+        auto operator*() const {
             if constexpr (std::is_const_v<T>) {
-                return const_proxy(list, index);    
+                return const_proxy(*list, index);
             } else {
-                return proxy(list, index);
+                return proxy(*list, index);
             }
             
         }
 
         iterator_base& operator++() {
-            index_type next_index = list.load_index(index);
+            index_type next_index = list->load_index(index);
             index = next_index;
             return *this;
         }
 
-        bool operator==(const iterator_base& other) {
+        bool operator==(const iterator_base& other) const {
             return index == other.index;
         }
     };
@@ -88,7 +425,7 @@ public:
             return *this;
         }
 
-        friend void swap(compact_forward_list<value_limit, max_size>::proxy first, compact_forward_list<value_limit, max_size>::proxy second) {
+        friend void swap(proxy first, proxy second) {
             const value_type first_value = first;
             first = second;
             second = first_value;
@@ -109,16 +446,54 @@ public:
     };
 
     compact_forward_list() {
-        data = new std::byte[byte_size];
         clear();
     }
 
-    ~compact_forward_list() {
-        delete [] data;
+    explicit compact_forward_list(std::byte* buffer) requires std::is_constructible_v<storage_policy<byte_size>, std::byte*> : storage(buffer) {
+        clear();
+    }
+
+    // The source is left empty (without a buffer for external_storage)
+    compact_forward_list(compact_forward_list&& other) : storage(std::move(other.storage)) {
+        if (other.storage.bytes()) {
+            other.clear();
+        }
+    }
+
+    compact_forward_list(const compact_forward_list&) = default;
+    compact_forward_list& operator=(const compact_forward_list&) = default;
+    compact_forward_list& operator=(compact_forward_list&&) = default;
+
+    // Uses the list written by serialize in buffer without copying it, e.g. a memory-mapped file
+    // or a received message. Changes to the list are changes to buffer. Besides the header, the
+    // links are checked in O(max_size) to form one list and one free list within the nodes.
+    compact_forward_list(adopt_serialized_t, const std::span<std::byte> buffer) requires std::is_constructible_v<storage_policy<byte_size>, std::byte*>
+        : storage(checked_serialized_list(buffer)) {
+        check_links();
+    }
+
+    // Copy of the list written by serialize in buffer, checked like the adopting constructor
+    static compact_forward_list deserialize(const std::span<const std::byte> buffer) requires std::is_default_constructible_v<storage_policy<byte_size>> {
+        const std::byte* list_bytes = checked_serialized_list(buffer);
+        compact_forward_list list;
+        std::copy(list_bytes, list_bytes+byte_size, list.storage.bytes());
+        list.check_links();
+        return list;
+    }
+
+    // Writes the header and the buffer to the first serialized_bytes bytes of out
+    size_t serialize(const std::span<std::byte> out) const {
+        if (out.size() < serialized_bytes) {
+            throw std::invalid_argument("compact_forward_list: serialize needs serialized_bytes bytes");
+        }
+        compact_detail::store_serialized_header(out.data(), value_bits, count_bits, layout::layout_id, max_size);
+        std::copy(storage.bytes(), storage.bytes()+byte_size, out.data()+compact_detail::serialized_header_bytes);
+        return serialized_bytes;
     }
 
     void clear(){
         store_free_index(1);
+        store_tail_index(0);
         store_first_index(0);
         store_index(1, 0);
     }
@@ -127,40 +502,51 @@ public:
         return std::equal(begin(), end(), other.begin(), other.end());
     }
 
+    // The list must not be full(), there is no node left and the free list would hand out index 0
     iterator insert_after(const iterator position, const value_type value) {
         const index_type new_element = store_in_free_node(value);
         const index_type next_element = load_index(position.index);
         store_index(position.index, new_element);
         store_index(new_element, next_element);
+        if (position.index == load_tail_index()) {
+            store_tail_index(new_element);
+        }
         return iterator(new_element, *this);
     }
 
+    // The list must not be full()
     void push_front(const value_type value) {
         const index_type new_element = store_in_free_node(value);
-        store_index(new_element, load_first_index());
-        store_first_index(new_element); 
+        const index_type first_element = load_first_index();
+        store_index(new_element, first_element);
+        store_first_index(new_element);
+        if (first_element == 0) {
+            store_tail_index(new_element);
+        }
     }
 
     iterator erase_after(const iterator position) {
         const index_type next_element = load_index(position.index);
         const index_type next_next_element = load_index(next_element);
-        const index_type first_free = load_free_index();
 
-        store_index(next_element, first_free);
-        store_free_index(next_element);
         store_index(position.index, next_next_element);
+        release_node(next_element);
+        if (next_element == load_tail_index()) {
+            store_tail_index(position.index);
+        }
 
-        return iterator(next_next_element, position.list);
+        return iterator(next_next_element, *position.list);
     }
 
     void pop_front() {
-        const index_type first_free = load_free_index();
         const index_type first_element = load_first_index();
         const index_type second_element = load_index(first_element);
 
         store_first_index(second_element);
-        store_index(first_element, first_free);
-        store_free_index(first_element);
+        release_node(first_element);
+        if (second_element == 0) {
+            store_tail_index(0);
+        }
     }
 
     // // Could have only one begin function with C++23 deducing this (P0847R7), but GCC does not support that yet - https://gcc.gnu.org/projects/cxx-status.html
@@ -169,6 +555,15 @@ public:
     //  return iterator_base<std::conditional_t<std::is_const_v<Self>, const value_type, value_type>(load_first_index(), *this);
     // }
 
+    // Index 0 is both the end and the position before the first element, the next index of node 0 is the first index
+    compact_forward_list::iterator before_begin() {
+        return iterator(0, *this);
+    }
+
+    compact_forward_list::const_iterator before_begin() const {
+        return const_iterator(0, *this);
+    }
+
     compact_forward_list::iterator begin() {
         return iterator(load_first_index(), *this);
     }
@@ -185,28 +580,329 @@ public:
         return const_iterator(0, *this);
     }
 
+    // The list must not be full()
     void push_back(const value_type value) {
-        index_type new_element = store_in_free_node(value);
+        const index_type new_element = store_in_free_node(value);
         store_index(new_element, 0);
+        //Tail 0 of an empty list makes this store the first index
+        store_index(load_tail_index(), new_element);
+        store_tail_index(new_element);
+    }
+
+    bool empty() const {
+        return load_first_index() == 0;
+    }
+
+    // True when all max_size nodes hold elements
+    bool full() const {
+        return load_free_index() == 0;
+    }
+
+    template <std::ranges::input_range Range>
+    void assign(Range&& values) {
+        clear();
+        for(const auto value : values) {
+            push_back(value);
+        }
+    }
+
+    // Moves all elements of other after position. Within one buffer only links change, elements
+    // of another list have to be copied into free nodes of this one.
+    void splice_after(const iterator position, compact_forward_list& other) {
+        if (&other == this || other.empty()) {
+            return;
+        }
+        index_type last = position.index;
+        const index_type next_element = load_index(last);
+        for(index_type element = other.load_first_index(); element != 0; element = other.load_index(element)) {
+            const index_type new_element = store_in_free_node(other.load_value(element));
+            store_index(last, new_element);
+            last = new_element;
+        }
+        store_index(last, next_element);
+        if (position.index == load_tail_index()) {
+            store_tail_index(last);
+        }
+        other.clear();
+    }
+
+    // Moves the element following before_element (in other) after position
+    void splice_after(const iterator position, compact_forward_list& other, const iterator before_element) {
+        const index_type moved = other.load_index(before_element.index);
+        if (&other != this) {
+            insert_after(position, other.load_value(moved));
+            other.erase_after(before_element);
+            return;
+        }
+        if (position.index == before_element.index || position.index == moved) {
+            return;
+        }
+        //Unlink, then link after position
+        const index_type after_moved = load_index(moved);
+        store_index(before_element.index, after_moved);
+        if (moved == load_tail_index()) {
+            store_tail_index(before_element.index);
+        }
+        store_index(moved, load_index(position.index));
+        store_index(position.index, moved);
+        if (position.index == load_tail_index()) {
+            store_tail_index(moved);
+        }
+    }
+
+    template <typename Predicate>
+    size_t remove_if(Predicate predicate) {
+        size_t removed = 0;
+        index_type previous = 0;
+        index_type element = load_first_index();
+        while(element != 0) {
+            const index_type next_element = load_index(element);
+            if (predicate(load_value(element))) {
+                store_index(previous, next_element);
+                release_node(element);
+                removed++;
+            } else {
+                previous = element;
+            }
+            element = next_element;
+        }
+        store_tail_index(previous);
+        return removed;
+    }
+
+    size_t remove(const value_type value) {
+        return remove_if([value](const value_type element){ return element == value; });
+    }
+
+    void reverse() {
+        index_type previous = 0;
+        index_type element = load_first_index();
+        store_tail_index(element);
+        while(element != 0) {
+            const index_type next_element = load_index(element);
+            store_index(element, previous);
+            previous = element;
+            element = next_element;
+        }
+        store_first_index(previous);
+    }
+
+    // Removes consecutive duplicates, keeps the first of each run
+    size_t unique() {
+        size_t removed = 0;
+        index_type element = load_first_index();
+        if (element == 0) {
+            return removed;
+        }
+        value_type value = load_value(element);
+        index_type next_element = load_index(element);
+        while(next_element != 0) {
+            const value_type next_value = load_value(next_element);
+            const index_type after_next = load_index(next_element);
+            if (next_value == value) {
+                store_index(element, after_next);
+                release_node(next_element);
+                removed++;
+            } else {
+                element = next_element;
+                value = next_value;
+            }
+            next_element = after_next;
+        }
+        store_tail_index(element);
+        return removed;
+    }
+
+    // Merges sorted other into this sorted list, other ends up empty. Elements of other are copied
+    // into free nodes, so the combined size must not exceed max_size.
+    template <typename Compare = std::less<value_type>>
+    void merge(compact_forward_list& other, Compare compare = Compare{}) {
+        if (&other == this) {
+            return;
+        }
+        index_type previous = 0;
+        index_type element = load_first_index();
+        for(index_type other_element = other.load_first_index(); other_element != 0; other_element = other.load_index(other_element)) {
+            const value_type value = other.load_value(other_element);
+            while(element != 0 && !compare(value, load_value(element))) {
+                previous = element;
+                element = load_index(element);
+            }
+            const index_type new_element = store_in_free_node(value);
+            store_index(previous, new_element);
+            store_index(new_element, element);
+            previous = new_element;
+        }
+        if (element == 0 && previous != 0) {
+            store_tail_index(previous);
+        }
+        other.clear();
+    }
 
-        index_type iter = load_first_index();
-        if (iter == 0) {
-            store_first_index(new_element);
+    // Stable bottom-up merge sort. Runs of width 1, 2, 4, ... are merged by relinking indices,
+    // values are never moved.
+    template <typename Compare = std::less<value_type>>
+    void sort(Compare compare = Compare{}) {
+        for(size_t width = 1;; width *= 2) {
+            index_type first = load_first_index();
+            //Node 0 is the list head, linking after it stores the first index
+            index_type tail = 0;
+            size_t merges = 0;
+            while(first != 0) {
+                merges++;
+                index_type second = first;
+                size_t first_size = 0;
+                while(first_size < width && second != 0) {
+                    first_size++;
+                    second = load_index(second);
+                }
+                size_t second_size = width;
+
+                while(first_size > 0 || (second_size > 0 && second != 0)) {
+                    index_type taken;
+                    if (first_size == 0 || (second_size > 0 && second != 0 && compare(load_value(second), load_value(first)))) {
+                        taken = second;
+                        second = load_index(second);
+                        second_size--;
+                    } else {
+                        taken = first;
+                        first = load_index(first);
+                        first_size--;
+                    }
+                    store_index(tail, taken);
+                    tail = taken;
+                }
+                first = second;
+            }
+            store_index(tail, 0);
+            store_tail_index(tail);
+            if (merges <= 1) {
+                return;
+            }
+        }
+    }
+
+    // Moves the element at list position k into node k, so iteration order becomes memory order,
+    // and leaves the free nodes after the last element. In place and O(size) - placing an element
+    // evicts the old content of its node, the next index of the placed node temporarily records
+    // where that content went, until all next indices are rewritten as k+1 at the end.
+    void compact() {
+        index_type count = 0;
+        for(index_type element = load_first_index(); element != 0;) {
+            count++;
+            while(element < count) {
+                element = load_index(element);
+            }
+            const value_type value = load_value(element);
+            const index_type next_element = load_index(element);
+            if (element != count) {
+                store_value(element, load_value(count));
+                store_index(element, load_index(count));
+                store_value(count, value);
+            }
+            store_index(count, element);
+            element = next_element;
+        }
+
+        for(index_type element = 1; element < count; element++) {
+            store_index(element, element+1);
+        }
+        store_index(count, 0);
+        store_first_index(count != 0 ? 1 : 0);
+        store_tail_index(count);
+        if (count < max_size) {
+            store_free_index(count+1);
+            store_index(count+1, 0);
         } else {
-            index_type next = load_index(iter);
-            while(next != 0) {
-                iter = next;
-                next = load_index(iter);
+            store_free_index(0);
+        }
+    }
+
+    // Calls f with every value in order. Fields are read from one buffered word, which holds several
+    // small nodes - while next indices are consecutive (after compact) no node needs a new load.
+    template <typename F>
+    void for_each(F&& f) const {
+        if constexpr (value_bits > 56 || count_bits > 56) {
+            for(index_type element = load_first_index(); element != 0; element = load_index(element)) {
+                f(load_value(element));
+            }
+        } else {
+            size_t word_position = 0;
+            uint64_t word = compact_detail::load_word(storage.bytes(), byte_size, 0);
+            //Reads bit_count bits at bit_position, loads a new word only when they are not in the current one
+            auto read = [&]<size_t bit_count>(const size_t bit_position) {
+                if (bit_position < word_position*8 || bit_position + bit_count > word_position*8 + 64) {
+                    word_position = bit_position/8;
+                    word = compact_detail::load_word(storage.bytes(), byte_size, word_position);
+                }
+                return (word >> (bit_position - word_position*8)) & compact_detail::low_bits_mask<bit_count>;
+            };
+
+            for(index_type element = load_first_index(); element != 0;) {
+                f(value_type(read.template operator()<value_bits>(layout::value_position(element))));
+                element = index_type(read.template operator()<count_bits>(layout::index_position(element)));
             }
-            store_index(iter, new_element);
         }
     }
 
 private:
+    template <typename Byte>
+    static Byte* checked_serialized_list(const std::span<Byte> buffer) {
+        compact_detail::check_serialized_header(buffer, value_bits, count_bits, layout::layout_id, max_size, byte_size);
+        return buffer.data() + compact_detail::serialized_header_bytes;
+    }
+
+    // Throws std::invalid_argument unless the list from the first index ends at the tail index and
+    // the free list stays within the nodes, with no node reachable twice (which also rules out cycles)
+    void check_links() const {
+        auto fail = []{
+            throw std::invalid_argument("compact_forward_list: serialized list has corrupted links");
+        };
+        std::vector<bool> used(max_size+1, false);
+        auto visit = [&used, &fail](const index_type index) {
+            if (index == 0 || index > max_size || used[index]) {
+                fail();
+            }
+            used[index] = true;
+        };
+
+        index_type last = 0;
+        for(index_type element = load_first_index(); element != 0; element = load_index(element)) {
+            visit(element);
+            last = element;
+        }
+        if (load_tail_index() != last) {
+            fail();
+        }
+
+        for(index_type element = load_free_index(); element != 0;) {
+            visit(element);
+            const index_type next = load_index(element);
+            if (next == element) {
+                break;
+            }
+            if (next == 0) {
+                //Never used nodes follow, none of them may be in the list
+                for(size_t unused = element+1; unused <= max_size; unused++) {
+                    if (used[unused]) {
+                        fail();
+                    }
+                }
+                break;
+            }
+            element = next;
+        }
+    }
+
+    // Free list - a node whose next index is 0 is followed only by never used nodes, a node
+    // pointing to itself is the last free node. Free index 0 means the list is full.
     index_type store_in_free_node(const value_type value) {
         const index_type first_free = load_free_index();
+        assert(first_free != 0 && "compact_forward_list: no free node left");
         index_type next_free = load_index(first_free);
-        if (next_free == 0) {
+        if (next_free == first_free) {
+            next_free = 0;
+        } else if (next_free == 0 && first_free < max_size) {
             next_free = first_free+1;
             store_index(next_free, 0);
         }
@@ -216,64 +912,64 @@ private:
         return first_free;
     }
 
+    void release_node(const index_type index) {
+        const index_type first_free = load_free_index();
+        store_index(index, first_free != 0 ? first_free : index);
+        store_free_index(index);
+    }
+
+    // Positions come from the layout policy, the first index is the next index of a (nonexistent) node 0
     void store_index(const index_type index, const index_type value) {
-        store<count_bits, index_type>(count_bits+index*(value_bits+count_bits), value);
+        store<count_bits, index_type>(layout::index_position(index), value);
     }
 
     void store_free_index(const index_type value) {
         store<count_bits, index_type>(0, value);
     }
 
-    void store_first_index(const index_type value) {
+    void store_tail_index(const index_type value) {
         store<count_bits, index_type>(count_bits, value);
     }
 
+    void store_first_index(const index_type value) {
+        store<count_bits, index_type>(2*count_bits, value);
+    }
+
     void store_value(const index_type position, const value_type value) {
-        store<value_bits, value_type>(2*count_bits + (position-1)*(value_bits+count_bits), value);
+        store<value_bits, value_type>(layout::value_position(position), value);
     }
 
     template<size_t bit_count, class T>
     void store(const size_t bit_position, const T value) {
-        for(size_t i = 0; i < bit_count; i++) {
-            const int byte_position = (bit_position+i)/8;
-            const std::byte bit = std::byte{1}<<((bit_position+i)%8);
-            std::byte& target = data[byte_position];
-            if (value & (1<<i)) {
-                target |= bit;
-            } else {
-                target &= ~bit;
-            }
-        }
+        compact_detail::store_bits<bit_count, T>(storage.bytes(), byte_size, bit_position, value);
     }
 
     index_type load_index(const index_type index) const {
-        return load<count_bits, index_type>(count_bits+index*(value_bits+count_bits));
+        return load<count_bits, index_type>(layout::index_position(index));
     }
 
     index_type load_free_index() const {
         return load<count_bits, index_type>(0);
     }
 
-    index_type load_first_index() const {
+    index_type load_tail_index() const {
         return load<count_bits, index_type>(count_bits);
     }
 
+    index_type load_first_index() const {
+        return load<count_bits, index_type>(2*count_bits);
+    }
+
     value_type load_value(const index_type index) const {
-        return load<value_bits, value_type>(2*count_bits + (index-1)*(value_bits+count_bits));
+        return load<value_bits, value_type>(layout::value_position(index));
     }
 
     template<size_t bit_count, class T>
     T load(const size_t bit_position) const {
-        T result = 0;
-        for(size_t i = 0; i < bit_count; i++) {
-            const int byte_position = (bit_position+i)/8;
-            const std::byte bit = std::byte{1}<<(bit_position+i)%8;
-            std::byte& target = data[byte_position];
-            if ((target & bit) != std::byte{0}) {
-                result |= T{1}<<i;
-            }
-        }
-
-        return result;
+        return compact_detail::load_bits<bit_count, T>(storage.bytes(), byte_size, bit_position);
     }
 };
+
+// A list living in a buffer written by serialize, constructed with adopt_serialized
+template<size_t value_limit, size_t max_size, template <size_t, size_t, size_t> class layout_policy = interleaved_layout>
+using compact_forward_list_view = compact_forward_list<value_limit, max_size, external_storage, layout_policy>;
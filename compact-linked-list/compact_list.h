@@ -0,0 +1,326 @@
+#pragma once
+
+#include "compact_linked_list.h"
+
+#include <cassert>
+#include <iterator>
+
+// Doubly linked variant of compact_forward_list with the same buffer size: a node keeps the
+// previous index XOR the next index in count_bits bits. An iterator holds the indices of its node
+// and of the previous one, so it can step both ways and erase or insert at its node in O(1).
+// Inserting or erasing changes the links of the neighbours, iterators to the neighbouring nodes
+// are invalidated along with iterators to the erased node.
+template<size_t value_limit, size_t max_size, template <size_t> class storage_policy = heap_storage>
+class compact_list {
+private:
+    constexpr static size_t value_bits = ceil(log2(value_limit));
+    constexpr static size_t count_bits = ceil(log2(max_size+1));
+    constexpr static size_t node_bits = value_bits+count_bits;
+    constexpr static size_t bit_size = max_size*node_bits+3*count_bits;
+    constexpr static size_t byte_size = (bit_size+7)/8;
+    storage_policy<byte_size> storage;
+
+public:
+    constexpr static size_t required_bytes = byte_size;
+
+    using index_type = smallest_usigned_type_with_bits<count_bits>;
+    using value_type = smallest_usigned_type_with_bits<value_bits>;
+
+    class proxy {
+        friend class compact_list;
+
+        compact_list& list;
+        index_type position;
+        proxy(compact_list& list, index_type position) : list(list), position(position) {}
+    public:
+        operator value_type () const {
+            return list.load_value(position);
+        }
+
+        proxy& operator= (const value_type value) {
+            list.store_value(position, value);
+            return *this;
+        }
+
+        proxy& operator= (const proxy& other) {
+            list.store_value(position, other.list.load_value(other.position));
+            return *this;
+        }
+
+        friend void swap(proxy first, proxy second) {
+            const value_type first_value = first;
+            first = second;
+            second = first_value;
+        }
+    };
+
+    template <typename T>
+    class iterator_base {
+        friend class compact_list;
+        index_type previous;
+        index_type index;
+        T* list;
+
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = compact_list::value_type;
+        using pointer = void;
+        using reference = std::conditional_t<std::is_const_v<T>, value_type, proxy>;
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        iterator_base() = default;
+
+        iterator_base(index_type previous, index_type index, T& list) : previous(previous), index(index), list(&list) {
+        }
+
+        reference operator*() const {
+            if constexpr (std::is_const_v<T>) {
+                return list->load_value(index);
+            } else {
+                return proxy(*list, index);
+            }
+        }
+
+        iterator_base& operator++() {
+            const index_type next = list->load_link(index) ^ previous;
+            previous = index;
+            index = next;
+            return *this;
+        }
+
+        iterator_base operator++(int) {
+            iterator_base copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        iterator_base& operator--() {
+            const index_type before_previous = list->load_link(previous) ^ index;
+            index = previous;
+            previous = before_previous;
+            return *this;
+        }
+
+        iterator_base operator--(int) {
+            iterator_base copy = *this;
+            --*this;
+            return copy;
+        }
+
+        bool operator==(const iterator_base& other) const {
+            return index == other.index;
+        }
+    };
+
+    using iterator = iterator_base<compact_list>;
+    using const_iterator = iterator_base<const compact_list>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    compact_list() {
+        clear();
+    }
+
+    explicit compact_list(std::byte* buffer) requires std::is_constructible_v<storage_policy<byte_size>, std::byte*> : storage(buffer) {
+        clear();
+    }
+
+    // The source is left empty (without a buffer for external_storage)
+    compact_list(compact_list&& other) : storage(std::move(other.storage)) {
+        if (other.storage.bytes()) {
+            other.clear();
+        }
+    }
+
+    compact_list(const compact_list&) = default;
+    compact_list& operator=(const compact_list&) = default;
+    compact_list& operator=(compact_list&&) = default;
+
+    void clear() {
+        store_free_index(1);
+        store_first_index(0);
+        store_tail_index(0);
+        store_link(1, 0);
+    }
+
+    bool empty() const {
+        return load_first_index() == 0;
+    }
+
+    // True when all max_size nodes hold elements
+    bool full() const {
+        return load_free_index() == 0;
+    }
+
+    bool operator==(const compact_list& other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    // Inserts value before position and returns an iterator to it. The list must not be full(),
+    // there is no node left and the free list would hand out index 0.
+    iterator insert(const iterator position, const value_type value) {
+        const index_type new_element = store_in_free_node(value);
+        store_link(new_element, position.previous ^ position.index);
+        relink(position.previous, position.index, new_element);
+        relink(position.index, position.previous, new_element);
+        if (position.previous == 0) {
+            store_first_index(new_element);
+        }
+        if (position.index == 0) {
+            store_tail_index(new_element);
+        }
+        return iterator(position.previous, new_element, *this);
+    }
+
+    // Erases the element at position and returns an iterator to the following one
+    iterator erase(const iterator position) {
+        const index_type next = load_link(position.index) ^ position.previous;
+        relink(position.previous, position.index, next);
+        relink(next, position.index, position.previous);
+        if (position.previous == 0) {
+            store_first_index(next);
+        }
+        if (next == 0) {
+            store_tail_index(position.previous);
+        }
+        release_node(position.index);
+        return iterator(position.previous, next, *this);
+    }
+
+    // The list must not be full()
+    void push_front(const value_type value) {
+        insert(begin(), value);
+    }
+
+    // The list must not be full()
+    void push_back(const value_type value) {
+        insert(end(), value);
+    }
+
+    void pop_front() {
+        erase(begin());
+    }
+
+    void pop_back() {
+        erase(std::prev(end()));
+    }
+
+    value_type front() const {
+        return load_value(load_first_index());
+    }
+
+    value_type back() const {
+        return load_value(load_tail_index());
+    }
+
+    // The links read the same in both directions, so this only swaps the first and the tail index
+    void reverse() {
+        const index_type first_element = load_first_index();
+        store_first_index(load_tail_index());
+        store_tail_index(first_element);
+    }
+
+    iterator begin() {
+        return iterator(0, load_first_index(), *this);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(0, load_first_index(), *this);
+    }
+
+    iterator end() {
+        return iterator(load_tail_index(), 0, *this);
+    }
+
+    const_iterator end() const {
+        return const_iterator(load_tail_index(), 0, *this);
+    }
+
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+private:
+    // Replaces old_neighbour by new_neighbour in the link of element, index 0 has no link
+    void relink(const index_type element, const index_type old_neighbour, const index_type new_neighbour) {
+        if (element != 0) {
+            store_link(element, load_link(element) ^ old_neighbour ^ new_neighbour);
+        }
+    }
+
+    // Same free list encoding as compact_forward_list, through the links of free nodes
+    index_type store_in_free_node(const value_type value) {
+        const index_type first_free = load_free_index();
+        assert(first_free != 0 && "compact_list: no free node left");
+        index_type next_free = load_link(first_free);
+        if (next_free == first_free) {
+            next_free = 0;
+        } else if (next_free == 0 && first_free < max_size) {
+            next_free = first_free+1;
+            store_link(next_free, 0);
+        }
+        store_free_index(next_free);
+
+        store_value(first_free, value);
+        return first_free;
+    }
+
+    void release_node(const index_type index) {
+        const index_type first_free = load_free_index();
+        store_link(index, first_free != 0 ? first_free : index);
+        store_free_index(index);
+    }
+
+    // Layout: free index, first index, tail index, then nodes 1..max_size as (value, previous XOR next)
+    void store_link(const index_type index, const index_type value) {
+        compact_detail::store_bits<count_bits, index_type>(storage.bytes(), byte_size, 3*count_bits + (index-1)*node_bits + value_bits, value);
+    }
+
+    void store_free_index(const index_type value) {
+        compact_detail::store_bits<count_bits, index_type>(storage.bytes(), byte_size, 0, value);
+    }
+
+    void store_first_index(const index_type value) {
+        compact_detail::store_bits<count_bits, index_type>(storage.bytes(), byte_size, count_bits, value);
+    }
+
+    void store_tail_index(const index_type value) {
+        compact_detail::store_bits<count_bits, index_type>(storage.bytes(), byte_size, 2*count_bits, value);
+    }
+
+    void store_value(const index_type index, const value_type value) {
+        compact_detail::store_bits<value_bits, value_type>(storage.bytes(), byte_size, 3*count_bits + (index-1)*node_bits, value);
+    }
+
+    index_type load_link(const index_type index) const {
+        return compact_detail::load_bits<count_bits, index_type>(storage.bytes(), byte_size, 3*count_bits + (index-1)*node_bits + value_bits);
+    }
+
+    index_type load_free_index() const {
+        return compact_detail::load_bits<count_bits, index_type>(storage.bytes(), byte_size, 0);
+    }
+
+    index_type load_first_index() const {
+        return compact_detail::load_bits<count_bits, index_type>(storage.bytes(), byte_size, count_bits);
+    }
+
+    index_type load_tail_index() const {
+        return compact_detail::load_bits<count_bits, index_type>(storage.bytes(), byte_size, 2*count_bits);
+    }
+
+    value_type load_value(const index_type index) const {
+        return compact_detail::load_bits<value_bits, value_type>(storage.bytes(), byte_size, 3*count_bits + (index-1)*node_bits);
+    }
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "compact_linked_list.h"
+
+#include <cassert>
+#include <iterator>
+
+// Many bounded singly linked lists sharing one bit-packed node array and one free list. A list
+// is just a packed head index, so an empty list costs count_bits and no list reserves capacity
+// of its own. Nodes can be moved between lists in O(1) by relinking.
+template<size_t value_limit, size_t max_size, size_t list_count, template <size_t> class storage_policy = heap_storage>
+class compact_list_pool {
+private:
+    constexpr static size_t value_bits = ceil(log2(value_limit));
+    constexpr static size_t count_bits = ceil(log2(max_size+1));
+    constexpr static size_t node_bits = value_bits+count_bits;
+    constexpr static size_t nodes_position = (1+list_count)*count_bits;
+    constexpr static size_t bit_size = nodes_position + max_size*node_bits;
+    constexpr static size_t byte_size = (bit_size+7)/8;
+    storage_policy<byte_size> storage;
+
+public:
+    constexpr static size_t required_bytes = byte_size;
+
+    using index_type = smallest_usigned_type_with_bits<count_bits>;
+    using value_type = smallest_usigned_type_with_bits<value_bits>;
+    using list_id = size_t;
+
+    class const_iterator {
+        friend class compact_list_pool;
+        const compact_list_pool* pool;
+        index_type index;
+
+        const_iterator(const compact_list_pool* pool, index_type index) : pool(pool), index(index) {
+        }
+
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = compact_list_pool::value_type;
+        using pointer = void;
+        using reference = compact_list_pool::value_type;
+        using iterator_category = std::forward_iterator_tag;
+
+        const_iterator() = default;
+
+        value_type operator*() const {
+            return pool->load_value(index);
+        }
+
+        const_iterator& operator++() {
+            index = pool->load_index(index);
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return index == other.index;
+        }
+    };
+
+    compact_list_pool() {
+        clear();
+    }
+
+    explicit compact_list_pool(std::byte* buffer) requires std::is_constructible_v<storage_policy<byte_size>, std::byte*> : storage(buffer) {
+        clear();
+    }
+
+    // The source is left with all lists empty (without a buffer for external_storage)
+    compact_list_pool(compact_list_pool&& other) : storage(std::move(other.storage)) {
+        if (other.storage.bytes()) {
+            other.clear();
+        }
+    }
+
+    compact_list_pool(const compact_list_pool&) = default;
+    compact_list_pool& operator=(const compact_list_pool&) = default;
+    compact_list_pool& operator=(compact_list_pool&&) = default;
+
+    // Empties all lists
+    void clear() {
+        store_free_index(1);
+        for(list_id list = 0; list < list_count; list++) {
+            store_head_index(list, 0);
+        }
+        store_index(1, 0);
+    }
+
+    // Empties one list, O(its length)
+    void clear(const list_id list) {
+        while(!empty(list)) {
+            pop_front(list);
+        }
+    }
+
+    bool empty(const list_id list) const {
+        return load_head_index(list) == 0;
+    }
+
+    // True when no node is left for any list
+    bool full() const {
+        return load_free_index() == 0;
+    }
+
+    value_type front(const list_id list) const {
+        return load_value(load_head_index(list));
+    }
+
+    // The pool must not be full(), there is no node left and the free list would hand out index 0
+    void push_front(const list_id list, const value_type value) {
+        const index_type new_element = store_in_free_node(value);
+        store_index(new_element, load_head_index(list));
+        store_head_index(list, new_element);
+    }
+
+    void pop_front(const list_id list) {
+        const index_type first_element = load_head_index(list);
+        store_head_index(list, load_index(first_element));
+        release_node(first_element);
+    }
+
+    // Moves the first node of one list to the front of another, no value is copied
+    void splice_front(const list_id target, const list_id source) {
+        const index_type moved = load_head_index(source);
+        store_head_index(source, load_index(moved));
+        store_index(moved, load_head_index(target));
+        store_head_index(target, moved);
+    }
+
+    const_iterator begin(const list_id list) const {
+        return const_iterator(this, load_head_index(list));
+    }
+
+    const_iterator end([[maybe_unused]] const list_id list) const {
+        return const_iterator(this, 0);
+    }
+
+private:
+    // Same free list encoding as compact_forward_list - next index 0 is followed only by never
+    // used nodes, a node pointing to itself ends the list, free index 0 means no node is left
+    index_type store_in_free_node(const value_type value) {
+        const index_type first_free = load_free_index();
+        assert(first_free != 0 && "compact_list_pool: no free node left");
+        index_type next_free = load_index(first_free);
+        if (next_free == first_free) {
+            next_free = 0;
+        } else if (next_free == 0 && first_free < max_size) {
+            next_free = first_free+1;
+            store_index(next_free, 0);
+        }
+        store_free_index(next_free);
+
+        store_value(first_free, value);
+        return first_free;
+    }
+
+    void release_node(const index_type index) {
+        const index_type first_free = load_free_index();
+        store_index(index, first_free != 0 ? first_free : index);
+        store_free_index(index);
+    }
+
+    // Layout: free index, head index of every list, then nodes 1..max_size as (value, next index)
+    void store_index(const index_type index, const index_type value) {
+        store<count_bits, index_type>(nodes_position + (index-1)*node_bits + value_bits, value);
+    }
+
+    void store_free_index(const index_type value) {
+        store<count_bits, index_type>(0, value);
+    }
+
+    void store_head_index(const list_id list, const index_type value) {
+        store<count_bits, index_type>((1+list)*count_bits, value);
+    }
+
+    void store_value(const index_type index, const value_type value) {
+        store<value_bits, value_type>(nodes_position + (index-1)*node_bits, value);
+    }
+
+    template<size_t bit_count, class T>
+    void store(const size_t bit_position, const T value) {
+        compact_detail::store_bits<bit_count, T>(storage.bytes(), byte_size, bit_position, value);
+    }
+
+    index_type load_index(const index_type index) const {
+        return load<count_bits, index_type>(nodes_position + (index-1)*node_bits + value_bits);
+    }
+
+    index_type load_free_index() const {
+        return load<count_bits, index_type>(0);
+    }
+
+    index_type load_head_index(const list_id list) const {
+        return load<count_bits, index_type>((1+list)*count_bits);
+    }
+
+    value_type load_value(const index_type index) const {
+        return load<value_bits, value_type>(nodes_position + (index-1)*node_bits);
+    }
+
+    template<size_t bit_count, class T>
+    T load(const size_t bit_position) const {
+        return compact_detail::load_bits<bit_count, T>(storage.bytes(), byte_size, bit_position);
+    }
+};
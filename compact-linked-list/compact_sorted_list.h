@@ -0,0 +1,395 @@
+#pragma once
+
+#include "compact_linked_list.h"
+
+#include <iterator>
+
+namespace compact_detail {
+    // Smallest w with denominator*2^w >= numerator
+    constexpr size_t ceil_log2_ratio(const unsigned __int128 numerator, const unsigned __int128 denominator) {
+        size_t w = 0;
+        while((denominator << w) < numerator) {
+            w++;
+        }
+        return w;
+    }
+}
+
+// Sorted set of values below value_limit, at most max_size of them, delta encoded in blocks of up
+// to block_size values. The skip index holds the first value, the length, the gap width and the
+// data offset of every block. A block stores the gaps between its values minus one, bit-packed at
+// the width of its largest gap. Blocks are split when they overflow and merged with a neighbour
+// when they drop below block_size/2 values, like the leaves of a B-tree, which bounds the number of
+// blocks and lets the buffer be sized for the worst case up front.
+template<size_t value_limit, size_t max_size, template <size_t> class storage_policy = heap_storage>
+class compact_sorted_list {
+private:
+    constexpr static size_t value_bits = ceil(log2(value_limit));
+    //A set holds at most value_limit values
+    constexpr static size_t max_count = std::min(max_size, value_limit);
+    constexpr static size_t count_bits = ceil(log2(max_count+1));
+    constexpr static size_t block_size = 64;
+    constexpr static size_t min_block_size = block_size/2;
+    constexpr static size_t max_blocks = std::max<size_t>(1, max_count/min_block_size);
+    constexpr static size_t block_count_bits = std::bit_width(max_blocks);
+    constexpr static size_t length_bits = std::bit_width(block_size-1);
+    constexpr static size_t width_bits = std::bit_width(value_bits);
+
+    // S gaps g_i in blocks of c_i values take sum (c_i-1)*bit_width(g_i) bits, and sum g_i is below
+    // value_limit. That is largest for g_i proportional to c_i-1, at most S*(1+log2(value_limit*(block_size-1)/S)).
+    // Each block also rounds up to a byte, and the decoding loads may read a word past the end.
+    constexpr static size_t gap_count = max_count-1;
+    constexpr static size_t max_gap_bits = gap_count == 0 ? 0 : std::min(value_bits, 1 + compact_detail::ceil_log2_ratio((unsigned __int128)value_limit*(block_size-1), gap_count));
+    constexpr static size_t data_bytes = (gap_count*max_gap_bits+7)/8 + max_blocks + 8;
+    constexpr static size_t offset_bits = std::bit_width(data_bytes);
+
+    constexpr static size_t entry_bits = value_bits + length_bits + width_bits + offset_bits;
+    constexpr static size_t entries_position = count_bits + block_count_bits;
+    constexpr static size_t data_position = (entries_position + max_blocks*entry_bits + 7)/8;
+    constexpr static size_t byte_size = data_position + data_bytes;
+    storage_policy<byte_size> storage;
+
+public:
+    constexpr static size_t required_bytes = byte_size;
+
+    using value_type = smallest_usigned_type_with_bits<value_bits>;
+
+    class const_iterator {
+        friend class compact_sorted_list;
+        const compact_sorted_list* list;
+        size_t block;
+        size_t position;
+        uint64_t value;
+
+        const_iterator(const compact_sorted_list* list, size_t block) : list(list), block(block), position(0), value(0) {
+            if (block < list->load_block_count()) {
+                value = list->load_first(block);
+            }
+        }
+
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = compact_sorted_list::value_type;
+        using pointer = void;
+        using reference = compact_sorted_list::value_type;
+        using iterator_category = std::forward_iterator_tag;
+
+        const_iterator() = default;
+
+        value_type operator*() const {
+            return value_type(value);
+        }
+
+        const_iterator& operator++() {
+            if (position+1 < list->load_length(block)) {
+                value += list->load_gap(block, position) + 1;
+                position++;
+            } else {
+                *this = const_iterator(list, block+1);
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return block == other.block && position == other.position;
+        }
+    };
+
+    compact_sorted_list() {
+        clear();
+    }
+
+    explicit compact_sorted_list(std::byte* buffer) requires std::is_constructible_v<storage_policy<byte_size>, std::byte*> : storage(buffer) {
+        clear();
+    }
+
+    // The source is left empty (without a buffer for external_storage)
+    compact_sorted_list(compact_sorted_list&& other) : storage(std::move(other.storage)) {
+        if (other.storage.bytes()) {
+            other.clear();
+        }
+    }
+
+    compact_sorted_list(const compact_sorted_list&) = default;
+    compact_sorted_list& operator=(const compact_sorted_list&) = default;
+    compact_sorted_list& operator=(compact_sorted_list&&) = default;
+
+    void clear() {
+        store_size(0);
+        store_block_count(0);
+    }
+
+    size_t size() const {
+        return load_size();
+    }
+
+    bool empty() const {
+        return load_size() == 0;
+    }
+
+    constexpr static size_t capacity() {
+        return max_count;
+    }
+
+    bool contains(const value_type value) const {
+        if (load_block_count() == 0) {
+            return false;
+        }
+        //Decodes the block only up to value
+        const size_t block = find_block(value);
+        const size_t gaps = load_length(block)-1;
+        const std::byte* data = storage.bytes() + data_position + load_offset(block);
+        const size_t bytes_left = storage.bytes() + byte_size - data;
+        uint64_t current = load_first(block);
+        with_width(load_width(block), [&](auto width) {
+            for(size_t i = 0; i < gaps && current < value; i++) {
+                current += compact_detail::load_bits<decltype(width)::value, uint64_t>(data, bytes_left, i*width) + 1;
+            }
+        });
+        return current == value;
+    }
+
+    // Returns false if value was already in the list. Values have to be smaller than value_limit,
+    // a new value must not be inserted into a full list.
+    bool insert(const value_type value) {
+        if (load_block_count() == 0) {
+            const uint64_t first = value;
+            replace_blocks(0, 0, &first, 1, 1);
+            store_size(1);
+            return true;
+        }
+        const size_t block = find_block(value);
+        block_values values;
+        const size_t length = decode_block(block, values.data());
+        const auto position = std::lower_bound(values.begin(), values.begin()+length, uint64_t(value));
+        if (position != values.begin()+length && *position == value) {
+            return false;
+        }
+        std::copy_backward(position, values.begin()+length, values.begin()+length+1);
+        *position = value;
+        replace_blocks(block, 1, values.data(), length+1, length+1 > block_size ? 2 : 1);
+        store_size(load_size()+1);
+        return true;
+    }
+
+    // Returns false if value was not in the list
+    bool erase(const value_type value) {
+        if (load_block_count() == 0) {
+            return false;
+        }
+        size_t block = find_block(value);
+        block_values values;
+        size_t length = decode_block(block, values.data());
+        const auto position = std::lower_bound(values.begin(), values.begin()+length, uint64_t(value));
+        if (position == values.begin()+length || *position != value) {
+            return false;
+        }
+        std::copy(position+1, values.begin()+length, position);
+        length--;
+        store_size(load_size()-1);
+
+        const size_t block_count = load_block_count();
+        if (block_count == 1 || length >= min_block_size) {
+            replace_blocks(block, 1, values.data(), length, length == 0 ? 0 : 1);
+            return true;
+        }
+        //Merges with a neighbour, or evens out the two blocks if they do not fit in one
+        if (block+1 < block_count) {
+            length += decode_block(block+1, values.data()+length);
+        } else {
+            block--;
+            const size_t neighbour_length = load_length(block);
+            std::copy_backward(values.begin(), values.begin()+length, values.begin()+length+neighbour_length);
+            decode_block(block, values.data());
+            length += neighbour_length;
+        }
+        replace_blocks(block, 2, values.data(), length, length > block_size ? 2 : 1);
+        return true;
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, load_block_count());
+    }
+
+    bool operator==(const compact_sorted_list& other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    // Calls f with every value in order, the gaps of a block are decoded by a loop specialized
+    // for their width
+    template <typename F>
+    void for_each(F&& f) const {
+        const size_t block_count = load_block_count();
+        for(size_t block = 0; block < block_count; block++) {
+            uint64_t value = load_first(block);
+            f(value_type(value));
+            const size_t gaps = load_length(block)-1;
+            const std::byte* data = storage.bytes() + data_position + load_offset(block);
+            const size_t bytes_left = storage.bytes() + byte_size - data;
+            with_width(load_width(block), [&](auto width) {
+                for(size_t i = 0; i < gaps; i++) {
+                    value += compact_detail::load_bits<decltype(width)::value, uint64_t>(data, bytes_left, i*width) + 1;
+                    f(value_type(value));
+                }
+            });
+        }
+    }
+
+private:
+    //A block being split or two blocks being merged
+    using block_values = std::array<uint64_t, 2*block_size+1>;
+
+    template <typename Kernel>
+    static void with_width(const size_t width, Kernel&& kernel) {
+        with_width(width, kernel, std::make_index_sequence<value_bits+1>{});
+    }
+
+    template <typename Kernel, size_t... widths>
+    static void with_width(const size_t width, Kernel& kernel, std::index_sequence<widths...>) {
+        ((width == widths && (kernel(std::integral_constant<size_t, widths>{}), true)) || ...);
+    }
+
+    // Last block whose first value is not larger than value, or block 0
+    size_t find_block(const value_type value) const {
+        size_t low = 0;
+        size_t high = load_block_count();
+        while(low < high) {
+            const size_t middle = (low+high)/2;
+            if (load_first(middle) <= value) {
+                low = middle+1;
+            } else {
+                high = middle;
+            }
+        }
+        return low == 0 ? 0 : low-1;
+    }
+
+    size_t decode_block(const size_t block, uint64_t* values) const {
+        const size_t length = load_length(block);
+        const std::byte* data = storage.bytes() + data_position + load_offset(block);
+        const size_t bytes_left = storage.bytes() + byte_size - data;
+        values[0] = load_first(block);
+        with_width(load_width(block), [&](auto width) {
+            for(size_t i = 1; i < length; i++) {
+                values[i] = values[i-1] + compact_detail::load_bits<decltype(width)::value, uint64_t>(data, bytes_left, (i-1)*width) + 1;
+            }
+        });
+        return length;
+    }
+
+    static size_t gap_width(const uint64_t* values, const size_t length) {
+        uint64_t largest_gap = 0;
+        for(size_t i = 1; i < length; i++) {
+            largest_gap = std::max(largest_gap, values[i]-values[i-1]-1);
+        }
+        return std::bit_width(largest_gap);
+    }
+
+    static size_t gap_bytes(const size_t length, const size_t width) {
+        return ((length-1)*width+7)/8;
+    }
+
+    size_t data_end() const {
+        const size_t block_count = load_block_count();
+        return block_count == 0 ? 0 : load_offset(block_count-1) + gap_bytes(load_length(block_count-1), load_width(block_count-1));
+    }
+
+    // Replaces old_blocks blocks from first_block on with count values split evenly into new_blocks
+    // blocks (at most 2), moving the data and the skip index entries of the following blocks
+    void replace_blocks(const size_t first_block, const size_t old_blocks, const uint64_t* values, const size_t count, const size_t new_blocks) {
+        const size_t block_count = load_block_count();
+        std::array<size_t, 2> lengths{};
+        std::array<size_t, 2> widths{};
+        size_t new_bytes = 0;
+        for(size_t block = 0, first_value = 0; block < new_blocks; first_value += lengths[block], block++) {
+            lengths[block] = count/new_blocks + (block < count%new_blocks);
+            widths[block] = gap_width(values+first_value, lengths[block]);
+            new_bytes += gap_bytes(lengths[block], widths[block]);
+        }
+
+        const size_t end_block = first_block+old_blocks;
+        const size_t tail_end = data_end();
+        const size_t begin = first_block < block_count ? load_offset(first_block) : tail_end;
+        const size_t end = end_block < block_count ? load_offset(end_block) : tail_end;
+        std::byte* data = storage.bytes() + data_position;
+        std::memmove(data + begin + new_bytes, data + end, tail_end - end);
+
+        //The entries after the replaced ones move by new_blocks-old_blocks, their data by new_bytes-(end-begin)
+        const auto move_entry = [&](const size_t block) {
+            store_entry(block + new_blocks - old_blocks, load_first(block), load_length(block), load_width(block), load_offset(block) + new_bytes - (end - begin));
+        };
+        if (new_blocks > old_blocks) {
+            for(size_t block = block_count; block > end_block; block--) {
+                move_entry(block-1);
+            }
+        } else {
+            for(size_t block = end_block; block < block_count; block++) {
+                move_entry(block);
+            }
+        }
+
+        for(size_t block = 0, first_value = 0, offset = begin; block < new_blocks; offset += gap_bytes(lengths[block], widths[block]), first_value += lengths[block], block++) {
+            store_entry(first_block+block, values[first_value], lengths[block], widths[block], offset);
+            for(size_t i = 1; i < lengths[block]; i++) {
+                compact_detail::store_bits(data, data_bytes, offset*8 + (i-1)*widths[block], widths[block], values[first_value+i]-values[first_value+i-1]-1);
+            }
+        }
+        store_block_count(block_count + new_blocks - old_blocks);
+    }
+
+    // Layout: size, block count, the skip index entries (first value, length-1, gap width, data
+    // offset), then the gaps of the blocks from the next byte on
+    void store_size(const size_t size) {
+        compact_detail::store_bits<count_bits, uint64_t>(storage.bytes(), byte_size, 0, size);
+    }
+
+    size_t load_size() const {
+        return compact_detail::load_bits<count_bits, uint64_t>(storage.bytes(), byte_size, 0);
+    }
+
+    void store_block_count(const size_t block_count) {
+        compact_detail::store_bits<block_count_bits, uint64_t>(storage.bytes(), byte_size, count_bits, block_count);
+    }
+
+    size_t load_block_count() const {
+        return compact_detail::load_bits<block_count_bits, uint64_t>(storage.bytes(), byte_size, count_bits);
+    }
+
+    void store_entry(const size_t block, const uint64_t first, const size_t length, const size_t width, const size_t offset) {
+        const size_t position = entries_position + block*entry_bits;
+        compact_detail::store_bits<value_bits, uint64_t>(storage.bytes(), byte_size, position, first);
+        compact_detail::store_bits<length_bits, uint64_t>(storage.bytes(), byte_size, position + value_bits, length-1);
+        compact_detail::store_bits<width_bits, uint64_t>(storage.bytes(), byte_size, position + value_bits + length_bits, width);
+        compact_detail::store_bits<offset_bits, uint64_t>(storage.bytes(), byte_size, position + value_bits + length_bits + width_bits, offset);
+    }
+
+    uint64_t load_first(const size_t block) const {
+        return compact_detail::load_bits<value_bits, uint64_t>(storage.bytes(), byte_size, entries_position + block*entry_bits);
+    }
+
+    size_t load_length(const size_t block) const {
+        return compact_detail::load_bits<length_bits, uint64_t>(storage.bytes(), byte_size, entries_position + block*entry_bits + value_bits) + 1;
+    }
+
+    size_t load_width(const size_t block) const {
+        return compact_detail::load_bits<width_bits, uint64_t>(storage.bytes(), byte_size, entries_position + block*entry_bits + value_bits + length_bits);
+    }
+
+    size_t load_offset(const size_t block) const {
+        return compact_detail::load_bits<offset_bits, uint64_t>(storage.bytes(), byte_size, entries_position + block*entry_bits + value_bits + length_bits + width_bits);
+    }
+
+    uint64_t load_gap(const size_t block, const size_t position) const {
+        return compact_detail::load_bits(storage.bytes(), byte_size, (data_position + load_offset(block))*8 + position*load_width(block), load_width(block));
+    }
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "compact_linked_list.h"
+
+#include <atomic>
+
+// Bounded lock-free queue of values below value_limit between one producer and one consumer
+// thread, packed at value_bits each like compact_forward_list. The values live in atomic 64-bit
+// words inside the object, so nothing is allocated. Only the producer writes words, it rewrites a
+// whole word with the bits of the other slots unchanged, which is safe with a single writer.
+// try_push and try_pop are wait-free, the batched versions publish many values with one store.
+template<size_t value_limit, size_t max_size>
+class compact_spsc_queue {
+private:
+    constexpr static size_t value_bits = ceil(log2(value_limit));
+    constexpr static size_t word_count = (max_size*value_bits+63)/64;
+    constexpr static size_t cache_line = 64;
+
+    //Consumer side - next position to pop and the last tail it has seen
+    alignas(cache_line) std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+    //Producer side - next position to push and the last head it has seen
+    alignas(cache_line) std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+    alignas(cache_line) std::array<std::atomic<uint64_t>, word_count> words{};
+
+public:
+    using value_type = smallest_usigned_type_with_bits<value_bits>;
+
+    compact_spsc_queue() = default;
+    compact_spsc_queue(const compact_spsc_queue&) = delete;
+    compact_spsc_queue& operator=(const compact_spsc_queue&) = delete;
+
+    constexpr static size_t capacity() {
+        return max_size;
+    }
+
+    // Producer only
+    bool try_push(const value_type value) {
+        const size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cached_head == max_size) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (position - cached_head == max_size) {
+                return false;
+            }
+        }
+        store_value(position % max_size, value);
+        tail.store(position+1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only, pushes as many of count values as fit and returns how many
+    size_t try_push(const value_type* values, const size_t count) {
+        const size_t position = tail.load(std::memory_order_relaxed);
+        if (max_size - (position - cached_head) < count) {
+            cached_head = head.load(std::memory_order_acquire);
+        }
+        const size_t pushed = std::min(count, max_size - (position - cached_head));
+        for(size_t i = 0; i < pushed; i++) {
+            store_value((position+i) % max_size, values[i]);
+        }
+        tail.store(position+pushed, std::memory_order_release);
+        return pushed;
+    }
+
+    // Consumer only
+    bool try_pop(value_type& value) {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (position == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (position == cached_tail) {
+                return false;
+            }
+        }
+        value = load_value(position % max_size);
+        head.store(position+1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only, pops at most count values into values and returns how many
+    size_t try_pop(value_type* values, const size_t count) {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (cached_tail - position < count) {
+            cached_tail = tail.load(std::memory_order_acquire);
+        }
+        const size_t popped = std::min(count, cached_tail - position);
+        for(size_t i = 0; i < popped; i++) {
+            values[i] = load_value((position+i) % max_size);
+        }
+        head.store(position+popped, std::memory_order_release);
+        return popped;
+    }
+
+    // Exact only when neither side is running
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    // A value at bit position i*value_bits can continue in the following word
+    void store_value(const size_t index, const value_type value) {
+        if constexpr (value_bits > 0) {
+            const size_t bit_position = index*value_bits;
+            const size_t word = bit_position/64;
+            const size_t shift = bit_position%64;
+            const uint64_t mask = compact_detail::low_bits_mask<value_bits> << shift;
+            words[word].store((words[word].load(std::memory_order_relaxed) & ~mask) | ((uint64_t(value) << shift) & mask), std::memory_order_relaxed);
+            if (shift + value_bits > 64) {
+                const uint64_t high_mask = compact_detail::low_bits_mask<value_bits> >> (64-shift);
+                words[word+1].store((words[word+1].load(std::memory_order_relaxed) & ~high_mask) | (uint64_t(value) >> (64-shift)), std::memory_order_relaxed);
+            }
+        }
+    }
+
+    value_type load_value(const size_t index) const {
+        if constexpr (value_bits == 0) {
+            return 0;
+        } else {
+            const size_t bit_position = index*value_bits;
+            const size_t word = bit_position/64;
+            const size_t shift = bit_position%64;
+            uint64_t result = words[word].load(std::memory_order_relaxed) >> shift;
+            if (shift + value_bits > 64) {
+                result |= words[word+1].load(std::memory_order_relaxed) << (64-shift);
+            }
+            return value_type(result & compact_detail::low_bits_mask<value_bits>);
+        }
+    }
+};
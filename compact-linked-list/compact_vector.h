@@ -0,0 +1,235 @@
+#pragma once
+
+#include "compact_linked_list.h"
+
+#include <iterator>
+
+// Bounded sequence of small values packed at value_bits each, without the next index of
+// compact_forward_list. Blocks of 8 values start at a byte boundary and take exactly value_bits
+// bytes, bulk unpack and pack convert whole blocks with unrolled word loads and stores.
+template<size_t value_limit, size_t max_size, template <size_t> class storage_policy = heap_storage>
+class compact_vector {
+private:
+    constexpr static size_t value_bits = ceil(log2(value_limit));
+    constexpr static size_t count_bits = ceil(log2(max_size+1));
+    constexpr static size_t header_bytes = (count_bits+7)/8;
+    constexpr static size_t values_position = header_bytes*8;
+    //Padded by one word so the block kernels never load past the end
+    constexpr static size_t byte_size = header_bytes + (max_size*value_bits+7)/8 + 8;
+    constexpr static size_t block_size = 8;
+    storage_policy<byte_size> storage;
+
+public:
+    constexpr static size_t required_bytes = byte_size;
+
+    using size_type = smallest_usigned_type_with_bits<count_bits>;
+    using value_type = smallest_usigned_type_with_bits<value_bits>;
+
+    class proxy {
+        friend class compact_vector;
+
+        compact_vector& vector;
+        size_t position;
+        proxy(compact_vector& vector, size_t position) : vector(vector), position(position) {}
+    public:
+        operator value_type () const {
+            return vector.load_value(position);
+        }
+
+        proxy& operator= (const value_type value) {
+            vector.store_value(position, value);
+            return *this;
+        }
+
+        proxy& operator= (const proxy& other) {
+            vector.store_value(position, other.vector.load_value(other.position));
+            return *this;
+        }
+
+        friend void swap(proxy first, proxy second) {
+            const value_type first_value = first;
+            first = second;
+            second = first_value;
+        }
+    };
+
+    class const_iterator {
+        friend class compact_vector;
+        const compact_vector* vector;
+        size_t position;
+
+        const_iterator(const compact_vector* vector, size_t position) : vector(vector), position(position) {
+        }
+
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = compact_vector::value_type;
+        using pointer = void;
+        using reference = compact_vector::value_type;
+        using iterator_category = std::forward_iterator_tag;
+
+        const_iterator() = default;
+
+        value_type operator*() const {
+            return vector->load_value(position);
+        }
+
+        const_iterator& operator++() {
+            position++;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return position == other.position;
+        }
+    };
+
+    compact_vector() {
+        clear();
+    }
+
+    explicit compact_vector(std::byte* buffer) requires std::is_constructible_v<storage_policy<byte_size>, std::byte*> : storage(buffer) {
+        clear();
+    }
+
+    // The source is left empty (without a buffer for external_storage)
+    compact_vector(compact_vector&& other) : storage(std::move(other.storage)) {
+        if (other.storage.bytes()) {
+            other.clear();
+        }
+    }
+
+    compact_vector(const compact_vector&) = default;
+    compact_vector& operator=(const compact_vector&) = default;
+    compact_vector& operator=(compact_vector&&) = default;
+
+    void clear() {
+        store_size(0);
+    }
+
+    size_t size() const {
+        return load_size();
+    }
+
+    bool empty() const {
+        return load_size() == 0;
+    }
+
+    constexpr static size_t capacity() {
+        return max_size;
+    }
+
+    value_type operator[](const size_t position) const {
+        return load_value(position);
+    }
+
+    proxy operator[](const size_t position) {
+        return proxy(*this, position);
+    }
+
+    void push_back(const value_type value) {
+        const size_t position = load_size();
+        store_value(position, value);
+        store_size(position+1);
+    }
+
+    void pop_back() {
+        store_size(load_size()-1);
+    }
+
+    // Sets the size, new elements are not initialized
+    void resize(const size_t size) {
+        store_size(size);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, load_size());
+    }
+
+    bool operator==(const compact_vector& other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    // Copies count elements starting at first into output
+    void unpack(size_t first, size_t count, uint32_t* output) const requires (value_bits <= 32) {
+        for(; count > 0 && first % block_size != 0; first++, count--) {
+            *output++ = load_value(first);
+        }
+        const std::byte* block = storage.bytes() + header_bytes + first/block_size*value_bits;
+        for(; count >= block_size; first += block_size, count -= block_size, output += block_size, block += value_bits) {
+            unpack_block(block, output, std::make_index_sequence<block_size>{});
+        }
+        for(; count > 0; first++, count--) {
+            *output++ = load_value(first);
+        }
+    }
+
+    // Writes count values from input to positions first, first+1, ..., growing the size if needed.
+    // Values have to be smaller than value_limit.
+    void pack(size_t first, size_t count, const uint32_t* input) requires (value_bits <= 32) {
+        if (first+count > load_size()) {
+            store_size(first+count);
+        }
+        for(; count > 0 && first % block_size != 0; first++, count--) {
+            store_value(first, *input++);
+        }
+        std::byte* block = storage.bytes() + header_bytes + first/block_size*value_bits;
+        for(; count >= block_size; first += block_size, count -= block_size, input += block_size, block += value_bits) {
+            pack_block(block, input, std::make_index_sequence<block_size>{});
+        }
+        for(; count > 0; first++, count--) {
+            store_value(first, *input++);
+        }
+    }
+
+    void assign(const uint32_t* input, const size_t count) requires (value_bits <= 32) {
+        store_size(0);
+        pack(0, count, input);
+    }
+
+private:
+    // Value i of a block is at bit i*value_bits, a value of at most 32 bits shifted by at most 7
+    // always fits in the word loaded from its first byte
+    template <size_t... i>
+    static void unpack_block(const std::byte* block, uint32_t* output, std::index_sequence<i...>) {
+        ((output[i] = uint32_t(compact_detail::load_full_word(block + (i*value_bits)/8) >> ((i*value_bits)%8) & compact_detail::low_bits_mask<value_bits>)), ...);
+    }
+
+    // Builds the value_bits bytes of a block in registers and stores them at once
+    template <size_t... i>
+    static void pack_block(std::byte* block, const uint32_t* input, std::index_sequence<i...>) {
+        std::array<uint64_t, (block_size*value_bits)/64 + 2> words{};
+        ((words[(i*value_bits)/64] |= uint64_t(input[i]) << ((i*value_bits)%64),
+          words[(i*value_bits)/64 + 1] |= ((i*value_bits)%64 != 0) ? uint64_t(input[i]) >> ((64 - (i*value_bits)%64) % 64) : 0), ...);
+        for(size_t w = 0; w*8 < value_bits; w++) {
+            compact_detail::store_word(block, value_bits, w*8, words[w]);
+        }
+    }
+
+    // Layout: size in the first header_bytes bytes, then the values from the next byte on
+    void store_size(const size_t size) {
+        compact_detail::store_bits<count_bits, size_type>(storage.bytes(), byte_size, 0, size_type(size));
+    }
+
+    size_t load_size() const {
+        return compact_detail::load_bits<count_bits, size_type>(storage.bytes(), byte_size, 0);
+    }
+
+    void store_value(const size_t position, const value_type value) {
+        compact_detail::store_bits<value_bits, value_type>(storage.bytes(), byte_size, values_position + position*value_bits, value);
+    }
+
+    value_type load_value(const size_t position) const {
+        return compact_detail::load_bits<value_bits, value_type>(storage.bytes(), byte_size, values_position + position*value_bits);
+    }
+};
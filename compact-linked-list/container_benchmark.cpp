@@ -0,0 +1,297 @@
+#include "compact_linked_list.h"
+
+#include <chrono>
+#include <deque>
+#include <forward_list>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+// Every heap allocation of the program goes through these, live bytes include the allocator's
+// rounding (glibc malloc_usable_size) but not its per-chunk header
+size_t allocation_count = 0;
+size_t live_bytes = 0;
+
+void* operator new(const size_t size) {
+    void* pointer = malloc(size == 0 ? 1 : size);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    allocation_count++;
+    live_bytes += malloc_usable_size(pointer);
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer) {
+        live_bytes -= malloc_usable_size(pointer);
+        free(pointer);
+    }
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+void* operator new[](const size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void* pointer) noexcept {
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+struct result {
+    double bytes_per_element;
+    size_t allocations;
+    double push_front;
+    double push_back;
+    double erase;
+    double iteration;
+    double swap;
+};
+
+template <typename F>
+double nanoseconds_per_operation(const size_t operation_count, unsigned long long& checksum, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    checksum += f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count()*1e9/operation_count;
+}
+
+// Container specific operations, all containers hold size values i % value_limit
+template <typename Container>
+struct operations;
+
+template <size_t value_limit, size_t max_size>
+struct operations<compact_forward_list<value_limit, max_size>> {
+    using container = compact_forward_list<value_limit, max_size>;
+
+    static auto make() {
+        return std::make_unique<container>();
+    }
+
+    static void push_front(container& c, const uint64_t value) {
+        c.push_front(value);
+    }
+
+    static void push_back(container& c, const uint64_t value) {
+        c.push_back(value);
+    }
+
+    static void erase_every_other(container& c) {
+        for(auto it = c.begin(); it != c.end() && std::next(it) != c.end();) {
+            it = c.erase_after(it);
+        }
+    }
+};
+
+template <typename T>
+struct operations<std::forward_list<T>> {
+    using container = std::forward_list<T>;
+
+    static auto make() {
+        return std::make_unique<container>();
+    }
+
+    static void push_front(container& c, const uint64_t value) {
+        c.push_front(T(value));
+    }
+
+    //Keeps the position of the last element like the tail index of compact_forward_list
+    static void push_back(container& c, const uint64_t value) {
+        static thread_local typename container::iterator last;
+        last = c.empty() ? c.insert_after(c.before_begin(), T(value)) : c.insert_after(last, T(value));
+    }
+
+    static void erase_every_other(container& c) {
+        for(auto it = c.begin(); it != c.end() && std::next(it) != c.end();) {
+            it = c.erase_after(it);
+        }
+    }
+};
+
+template <typename T>
+struct operations<std::vector<T>> {
+    using container = std::vector<T>;
+
+    static auto make() {
+        return std::make_unique<container>();
+    }
+
+    static constexpr bool has_push_front = false;
+
+    static void push_back(container& c, const uint64_t value) {
+        c.push_back(T(value));
+    }
+
+    static void erase_every_other(container& c) {
+        size_t i = 0;
+        std::erase_if(c, [&i](const T&){ return i++ % 2 == 1; });
+    }
+};
+
+template <typename T>
+struct operations<std::deque<T>> {
+    using container = std::deque<T>;
+
+    static auto make() {
+        return std::make_unique<container>();
+    }
+
+    static void push_front(container& c, const uint64_t value) {
+        c.push_front(T(value));
+    }
+
+    static void push_back(container& c, const uint64_t value) {
+        c.push_back(T(value));
+    }
+
+    static void erase_every_other(container& c) {
+        size_t i = 0;
+        std::erase_if(c, [&i](const T&){ return i++ % 2 == 1; });
+    }
+};
+
+template <typename Ops>
+concept has_push_front = !requires { Ops::has_push_front; };
+
+template <typename Container, size_t value_limit, size_t max_size>
+result run(const size_t repetitions, unsigned long long& checksum) {
+    using ops = operations<Container>;
+    result r{};
+
+    //Memory of a full container, including the container object itself
+    {
+        const size_t allocations_before = allocation_count;
+        const size_t bytes_before = live_bytes;
+        auto c = ops::make();
+        for(size_t i = 0; i < max_size; i++) {
+            ops::push_back(*c, i % value_limit);
+        }
+        r.allocations = allocation_count - allocations_before;
+        r.bytes_per_element = double(live_bytes - bytes_before)/max_size;
+    }
+
+    if constexpr (has_push_front<ops>) {
+        r.push_front = nanoseconds_per_operation(repetitions*max_size, checksum, [&]{
+            unsigned long long sum = 0;
+            for(size_t rep = 0; rep < repetitions; rep++) {
+                auto c = ops::make();
+                for(size_t i = 0; i < max_size; i++) {
+                    ops::push_front(*c, i % value_limit);
+                }
+                sum += *c->begin();
+            }
+            return sum;
+        });
+    } else {
+        r.push_front = -1;
+    }
+
+    r.push_back = nanoseconds_per_operation(repetitions*max_size, checksum, [&]{
+        unsigned long long sum = 0;
+        for(size_t rep = 0; rep < repetitions; rep++) {
+            auto c = ops::make();
+            for(size_t i = 0; i < max_size; i++) {
+                ops::push_back(*c, i % value_limit);
+            }
+            sum += *c->begin();
+        }
+        return sum;
+    });
+
+    //The container is filled outside of the timed part for the remaining operations
+    auto c = ops::make();
+    r.erase = 0;
+    for(size_t rep = 0; rep < repetitions; rep++) {
+        c = ops::make();
+        for(size_t i = 0; i < max_size; i++) {
+            ops::push_back(*c, i % value_limit);
+        }
+        r.erase += nanoseconds_per_operation(max_size/2, checksum, [&]{
+            ops::erase_every_other(*c);
+            return *c->begin();
+        });
+    }
+    r.erase /= repetitions;
+
+    c = ops::make();
+    for(size_t i = 0; i < max_size; i++) {
+        ops::push_back(*c, i % value_limit);
+    }
+    r.iteration = nanoseconds_per_operation(repetitions*max_size, checksum, [&]{
+        unsigned long long sum = 0;
+        for(size_t rep = 0; rep < repetitions; rep++) {
+            for(const auto value : *c) {
+                sum += value;
+            }
+        }
+        return sum;
+    });
+
+    //Swaps neighbours through the iterators, a proxy swap for compact_forward_list
+    r.swap = nanoseconds_per_operation(repetitions*(max_size/2), checksum, [&]{
+        for(size_t rep = 0; rep < repetitions; rep++) {
+            for(auto it = c->begin(); it != c->end();) {
+                auto next = std::next(it);
+                if (next == c->end()) {
+                    break;
+                }
+                std::iter_swap(it, next);
+                it = std::next(next);
+            }
+        }
+        return *c->begin();
+    });
+    return r;
+}
+
+void print_row(const std::string& name, const result& r) {
+    std::cout << std::setw(34) << name << std::fixed << std::setprecision(2)
+              << std::setw(10) << r.bytes_per_element
+              << std::setw(8) << r.allocations;
+    for(const double value : {r.push_front, r.push_back, r.erase, r.iteration, r.swap}) {
+        if (value < 0) {
+            std::cout << std::setw(12) << "-";
+        } else {
+            std::cout << std::setw(12) << value;
+        }
+    }
+    std::cout << std::endl;
+}
+
+template <size_t value_limit, size_t max_size>
+void compare(const size_t repetitions) {
+    using value_type = smallest_usigned_type_with_bits<size_t(std::ceil(std::log2(value_limit)))>;
+    unsigned long long checksum = 0;
+    std::cout << std::endl << "<" << value_limit << ", " << max_size << ">" << std::endl;
+    print_row("compact_forward_list", run<compact_forward_list<value_limit, max_size>, value_limit, max_size>(repetitions, checksum));
+    print_row("std::forward_list", run<std::forward_list<value_type>, value_limit, max_size>(repetitions, checksum));
+    print_row("std::vector", run<std::vector<value_type>, value_limit, max_size>(repetitions, checksum));
+    print_row("std::deque", run<std::deque<value_type>, value_limit, max_size>(repetitions, checksum));
+    std::cout << std::setw(34) << "checksum " << checksum << std::endl;
+}
+
+int main() {
+    std::cout << std::setw(34) << "container" << std::setw(10) << "B/elem" << std::setw(8) << "allocs"
+              << std::setw(12) << "push_front" << std::setw(12) << "push_back" << std::setw(12) << "erase"
+              << std::setw(12) << "iterate" << std::setw(12) << "swap" << "   (ns/op)" << std::endl;
+    compare<2, 1000>(200);
+    compare<16, 1000>(200);
+    compare<256, 255>(500);
+    compare<1000, 1000>(200);
+    compare<(1 << 16), 10000>(20);
+    compare<(1 << 20), 10000>(20);
+    compare<(1ull << 32), 10000>(20);
+    compare<(1ull << 40), 100000>(2);
+    return 0;
+}
@@ -0,0 +1,349 @@
+#pragma once
+
+#include "compact_linked_list.h"
+
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+// compact_forward_list with the value limit and the maximum size chosen at construction, one
+// class serves every configuration. The layout and the free list are the same, fields are read
+// and written with masks computed at run time. for_each dispatches once to a loop specialized
+// for the node width, which reads value and next index of a node with a single load.
+class dynamic_compact_forward_list {
+public:
+    using index_type = uint64_t;
+    using value_type = uint64_t;
+
+private:
+    constexpr static size_t max_specialized_node_bits = 32;
+
+    size_t max_size;
+    size_t value_bits;
+    size_t count_bits;
+    size_t byte_size;
+    std::unique_ptr<std::byte[]> data;
+
+public:
+    class proxy {
+        friend class dynamic_compact_forward_list;
+
+        dynamic_compact_forward_list& list;
+        index_type position;
+        proxy(dynamic_compact_forward_list& list, index_type position) : list(list), position(position) {}
+    public:
+        operator value_type () const {
+            return list.load_value(position);
+        }
+
+        proxy& operator= (const value_type value) {
+            list.store_value(position, value);
+            return *this;
+        }
+
+        proxy& operator= (const proxy& other) {
+            list.store_value(position, other.list.load_value(other.position));
+            return *this;
+        }
+    };
+
+    template <typename T>
+    class iterator_base {
+        friend class dynamic_compact_forward_list;
+        index_type index;
+        T* list;
+
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = dynamic_compact_forward_list::value_type;
+        using pointer = void;
+        using reference = std::conditional_t<std::is_const_v<T>, value_type, proxy>;
+        using iterator_category = std::forward_iterator_tag;
+
+        iterator_base() = default;
+
+        iterator_base(index_type index, T& list) : index(index), list(&list) {
+        }
+
+        reference operator*() const {
+            if constexpr (std::is_const_v<T>) {
+                return list->load_value(index);
+            } else {
+                return proxy(*list, index);
+            }
+        }
+
+        iterator_base& operator++() {
+            index = list->load_index(index);
+            return *this;
+        }
+
+        iterator_base operator++(int) {
+            iterator_base copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const iterator_base& other) const {
+            return index == other.index;
+        }
+    };
+
+    using iterator = iterator_base<dynamic_compact_forward_list>;
+    using const_iterator = iterator_base<const dynamic_compact_forward_list>;
+
+    // Values have to be smaller than value_limit, at most max_size of them fit in the list
+    dynamic_compact_forward_list(const uint64_t value_limit, const size_t max_size)
+        : max_size(max_size),
+          value_bits(std::bit_width(value_limit-1)),
+          count_bits(std::bit_width(max_size)),
+          byte_size((max_size*(value_bits+count_bits)+3*count_bits+7)/8) {
+        if (value_limit == 0 || max_size == 0) {
+            throw std::invalid_argument("dynamic_compact_forward_list: value_limit and max_size have to be positive");
+        }
+        data.reset(new std::byte[byte_size]());
+        clear();
+    }
+
+    dynamic_compact_forward_list(const dynamic_compact_forward_list& other)
+        : max_size(other.max_size),
+          value_bits(other.value_bits),
+          count_bits(other.count_bits),
+          byte_size(other.byte_size),
+          data(new std::byte[other.byte_size]()) {
+        std::copy(other.data.get(), other.data.get()+byte_size, data.get());
+    }
+
+    dynamic_compact_forward_list& operator=(const dynamic_compact_forward_list& other) {
+        if (this != &other) {
+            *this = dynamic_compact_forward_list(other);
+        }
+        return *this;
+    }
+
+    // The source keeps its value limit and maximum size with a new empty buffer
+    dynamic_compact_forward_list(dynamic_compact_forward_list&& other)
+        : max_size(other.max_size),
+          value_bits(other.value_bits),
+          count_bits(other.count_bits),
+          byte_size(other.byte_size),
+          data(std::exchange(other.data, std::unique_ptr<std::byte[]>(new std::byte[other.byte_size]()))) {
+        other.clear();
+    }
+
+    // Swaps, the source holds the previous list of the target
+    dynamic_compact_forward_list& operator=(dynamic_compact_forward_list&& other) noexcept {
+        std::swap(max_size, other.max_size);
+        std::swap(value_bits, other.value_bits);
+        std::swap(count_bits, other.count_bits);
+        std::swap(byte_size, other.byte_size);
+        std::swap(data, other.data);
+        return *this;
+    }
+
+    size_t capacity() const noexcept {
+        return max_size;
+    }
+
+    // Bytes of the packed buffer, the same as required_bytes of the equivalent compact_forward_list
+    size_t buffer_bytes() const noexcept {
+        return byte_size;
+    }
+
+    void clear() {
+        store_free_index(1);
+        store_tail_index(0);
+        store_first_index(0);
+        store_index(1, 0);
+    }
+
+    bool empty() const {
+        return load_first_index() == 0;
+    }
+
+    // True when all max_size nodes hold elements
+    bool full() const {
+        return load_free_index() == 0;
+    }
+
+    bool operator==(const dynamic_compact_forward_list& other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+    // The list must not be full(), there is no node left and the free list would hand out index 0
+    iterator insert_after(const iterator position, const value_type value) {
+        const index_type new_element = store_in_free_node(value);
+        const index_type next_element = load_index(position.index);
+        store_index(position.index, new_element);
+        store_index(new_element, next_element);
+        if (position.index == load_tail_index()) {
+            store_tail_index(new_element);
+        }
+        return iterator(new_element, *this);
+    }
+
+    // The list must not be full()
+    void push_front(const value_type value) {
+        const index_type new_element = store_in_free_node(value);
+        const index_type first_element = load_first_index();
+        store_index(new_element, first_element);
+        store_first_index(new_element);
+        if (first_element == 0) {
+            store_tail_index(new_element);
+        }
+    }
+
+    // The list must not be full()
+    void push_back(const value_type value) {
+        const index_type new_element = store_in_free_node(value);
+        store_index(new_element, 0);
+        //Tail 0 of an empty list makes this store the first index
+        store_index(load_tail_index(), new_element);
+        store_tail_index(new_element);
+    }
+
+    iterator erase_after(const iterator position) {
+        const index_type next_element = load_index(position.index);
+        const index_type next_next_element = load_index(next_element);
+
+        store_index(position.index, next_next_element);
+        release_node(next_element);
+        if (next_element == load_tail_index()) {
+            store_tail_index(position.index);
+        }
+
+        return iterator(next_next_element, *this);
+    }
+
+    void pop_front() {
+        const index_type first_element = load_first_index();
+        const index_type second_element = load_index(first_element);
+
+        store_first_index(second_element);
+        release_node(first_element);
+        if (second_element == 0) {
+            store_tail_index(0);
+        }
+    }
+
+    value_type front() const {
+        return load_value(load_first_index());
+    }
+
+    // Index 0 is both the end and the position before the first element
+    iterator before_begin() {
+        return iterator(0, *this);
+    }
+
+    const_iterator before_begin() const {
+        return const_iterator(0, *this);
+    }
+
+    iterator begin() {
+        return iterator(load_first_index(), *this);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(load_first_index(), *this);
+    }
+
+    iterator end() {
+        return iterator(0, *this);
+    }
+
+    const_iterator end() const {
+        return const_iterator(0, *this);
+    }
+
+    // Calls f with every value in order
+    template <typename F>
+    void for_each(F&& f) const {
+        const size_t node_bits = value_bits+count_bits;
+        if (node_bits > max_specialized_node_bits || !for_each_dispatch(f, node_bits, std::make_index_sequence<max_specialized_node_bits+1>{})) {
+            for(index_type element = load_first_index(); element != 0; element = load_index(element)) {
+                f(load_value(element));
+            }
+        }
+    }
+
+private:
+    template <typename F, size_t... node_bits>
+    bool for_each_dispatch(F& f, const size_t bits, std::index_sequence<node_bits...>) const {
+        return ((bits == node_bits && (for_each_kernel<node_bits>(f), true)) || ...);
+    }
+
+    template <size_t node_bits, typename F>
+    void for_each_kernel(F& f) const {
+        const uint64_t value_mask = (uint64_t{1} << value_bits) - 1;
+        const size_t nodes_position = 3*count_bits;
+        for(index_type element = load_first_index(); element != 0;) {
+            const uint64_t node = compact_detail::load_bits<node_bits, uint64_t>(data.get(), byte_size, nodes_position + (element-1)*node_bits);
+            f(value_type(node & value_mask));
+            element = node >> value_bits;
+        }
+    }
+
+    // Same free list encoding as compact_forward_list
+    index_type store_in_free_node(const value_type value) {
+        const index_type first_free = load_free_index();
+        assert(first_free != 0 && "dynamic_compact_forward_list: no free node left");
+        index_type next_free = load_index(first_free);
+        if (next_free == first_free) {
+            next_free = 0;
+        } else if (next_free == 0 && first_free < max_size) {
+            next_free = first_free+1;
+            store_index(next_free, 0);
+        }
+        store_free_index(next_free);
+
+        store_value(first_free, value);
+        return first_free;
+    }
+
+    void release_node(const index_type index) {
+        const index_type first_free = load_free_index();
+        store_index(index, first_free != 0 ? first_free : index);
+        store_free_index(index);
+    }
+
+    // Layout: free index, tail index, first index, then nodes 1..max_size as (value, next index)
+    void store_index(const index_type index, const index_type value) {
+        compact_detail::store_bits(data.get(), byte_size, 2*count_bits+index*(value_bits+count_bits), count_bits, value);
+    }
+
+    void store_free_index(const index_type value) {
+        compact_detail::store_bits(data.get(), byte_size, 0, count_bits, value);
+    }
+
+    void store_tail_index(const index_type value) {
+        compact_detail::store_bits(data.get(), byte_size, count_bits, count_bits, value);
+    }
+
+    void store_first_index(const index_type value) {
+        compact_detail::store_bits(data.get(), byte_size, 2*count_bits, count_bits, value);
+    }
+
+    void store_value(const index_type index, const value_type value) {
+        compact_detail::store_bits(data.get(), byte_size, 3*count_bits + (index-1)*(value_bits+count_bits), value_bits, value);
+    }
+
+    index_type load_index(const index_type index) const {
+        return compact_detail::load_bits(data.get(), byte_size, 2*count_bits+index*(value_bits+count_bits), count_bits);
+    }
+
+    index_type load_free_index() const {
+        return compact_detail::load_bits(data.get(), byte_size, 0, count_bits);
+    }
+
+    index_type load_tail_index() const {
+        return compact_detail::load_bits(data.get(), byte_size, count_bits, count_bits);
+    }
+
+    index_type load_first_index() const {
+        return compact_detail::load_bits(data.get(), byte_size, 2*count_bits, count_bits);
+    }
+
+    value_type load_value(const index_type index) const {
+        return compact_detail::load_bits(data.get(), byte_size, 3*count_bits + (index-1)*(value_bits+count_bits), value_bits);
+    }
+};
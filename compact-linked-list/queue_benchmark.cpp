@@ -0,0 +1,187 @@
+#include "compact_spsc_queue.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Same queue with one uint32_t per slot, to see what packing costs
+template <size_t max_size>
+class plain_spsc_queue {
+    alignas(64) std::atomic<size_t> head{0};
+    size_t cached_tail = 0;
+    alignas(64) std::atomic<size_t> tail{0};
+    size_t cached_head = 0;
+    alignas(64) std::array<uint32_t, max_size> slots{};
+
+public:
+    using value_type = uint32_t;
+
+    bool try_push(const value_type value) {
+        const size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cached_head == max_size) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (position - cached_head == max_size) {
+                return false;
+            }
+        }
+        slots[position % max_size] = value;
+        tail.store(position+1, std::memory_order_release);
+        return true;
+    }
+
+    size_t try_push(const value_type* values, const size_t count) {
+        const size_t position = tail.load(std::memory_order_relaxed);
+        if (max_size - (position - cached_head) < count) {
+            cached_head = head.load(std::memory_order_acquire);
+        }
+        const size_t pushed = std::min(count, max_size - (position - cached_head));
+        for(size_t i = 0; i < pushed; i++) {
+            slots[(position+i) % max_size] = values[i];
+        }
+        tail.store(position+pushed, std::memory_order_release);
+        return pushed;
+    }
+
+    bool try_pop(value_type& value) {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (position == cached_tail) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (position == cached_tail) {
+                return false;
+            }
+        }
+        value = slots[position % max_size];
+        head.store(position+1, std::memory_order_release);
+        return true;
+    }
+
+    size_t try_pop(value_type* values, const size_t count) {
+        const size_t position = head.load(std::memory_order_relaxed);
+        if (cached_tail - position < count) {
+            cached_tail = tail.load(std::memory_order_acquire);
+        }
+        const size_t popped = std::min(count, cached_tail - position);
+        for(size_t i = 0; i < popped; i++) {
+            values[i] = slots[(position+i) % max_size];
+        }
+        head.store(position+popped, std::memory_order_release);
+        return popped;
+    }
+};
+
+void report(const std::string& name, const double seconds, const size_t operation_count, const unsigned long long checksum) {
+    std::cout << std::setw(48) << name << std::setw(10) << std::fixed << std::setprecision(2) << seconds*1e9/operation_count << " ns/op  (checksum " << checksum << ")" << std::endl;
+}
+
+// Producer and consumer threads moving count values, batch 1 uses try_push/try_pop of one value.
+// Both sides yield on a full or empty queue, so the numbers also mean something on a single core.
+template <typename Queue>
+void benchmark_throughput(const std::string& name, const size_t count, const size_t batch, const uint64_t value_limit) {
+    auto queue = std::make_unique<Queue>();
+    using value_type = typename Queue::value_type;
+    const auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]{
+        std::vector<value_type> values(batch);
+        for(size_t i = 0; i < count; i += batch) {
+            if (batch == 1) {
+                while(!queue->try_push(value_type(i % value_limit))) {
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+            for(size_t j = 0; j < batch; j++) {
+                values[j] = value_type((i+j) % value_limit);
+            }
+            for(size_t pushed = 0; pushed < batch;) {
+                const size_t now_pushed = queue->try_push(values.data()+pushed, batch-pushed);
+                if (now_pushed == 0) {
+                    std::this_thread::yield();
+                }
+                pushed += now_pushed;
+            }
+        }
+    });
+    unsigned long long checksum = 0;
+    std::vector<value_type> values(batch);
+    for(size_t received = 0; received < count;) {
+        if (batch == 1) {
+            if (queue->try_pop(values[0])) {
+                checksum += values[0];
+                received++;
+            } else {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        const size_t popped = queue->try_pop(values.data(), batch);
+        if (popped == 0) {
+            std::this_thread::yield();
+        }
+        for(size_t j = 0; j < popped; j++) {
+            checksum += values[j];
+        }
+        received += popped;
+    }
+    producer.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    report(name + " throughput, batch " + std::to_string(batch), seconds, count, checksum);
+}
+
+// Round trip of one value through a queue to the other thread and back through a second queue
+template <typename Queue>
+void benchmark_latency(const std::string& name, const size_t round_trips) {
+    auto there = std::make_unique<Queue>();
+    auto back = std::make_unique<Queue>();
+    using value_type = typename Queue::value_type;
+    std::thread echo([&]{
+        value_type value;
+        for(size_t i = 0; i < round_trips; i++) {
+            while(!there->try_pop(value)) {
+                std::this_thread::yield();
+            }
+            while(!back->try_push(value)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    const auto start = std::chrono::steady_clock::now();
+    unsigned long long checksum = 0;
+    for(size_t i = 0; i < round_trips; i++) {
+        while(!there->try_push(value_type(i % 2))) {
+            std::this_thread::yield();
+        }
+        value_type value;
+        while(!back->try_pop(value)) {
+            std::this_thread::yield();
+        }
+        checksum += value;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    echo.join();
+    report(name + " round trip", seconds, round_trips, checksum);
+}
+
+template <size_t value_limit, size_t max_size>
+void benchmark_queue(const size_t count) {
+    using compact_queue = compact_spsc_queue<value_limit, max_size>;
+    using plain_queue = plain_spsc_queue<max_size>;
+    std::string name = "<";
+    name.append(std::to_string(value_limit)).append(", ").append(std::to_string(max_size)).append(">");
+    std::cout << name << " " << sizeof(compact_queue) << " bytes compact, " << sizeof(plain_queue) << " bytes plain" << std::endl;
+    for(const size_t batch : {1, 64}) {
+        benchmark_throughput<compact_queue>(name + " compact", count, batch, value_limit);
+        benchmark_throughput<plain_queue>(name + " plain", count, batch, value_limit);
+    }
+    benchmark_latency<compact_queue>(name + " compact", count/100);
+    benchmark_latency<plain_queue>(name + " plain", count/100);
+}
+
+int main() {
+    benchmark_queue<1024, 4096>(10000000);
+    benchmark_queue<(1 << 20), 4096>(10000000);
+    return 0;
+}
@@ -1,100 +1,24 @@
-#include "packed_list.h"
-#include <iostream>
+#include "compact_linked_list.h"
+#include "compact_list_pool.h"
+#include "compact_vector.h"
+#include "dynamic_compact_forward_list.h"
+#include "compact_spsc_queue.h"
+#include "compact_sorted_list.h"
+#include "compact_list.h"
 #include <forward_list>
-#include <cassert>
+#include <list>
 #include <algorithm>
+#include <cstring>
+#include <memory>
 #include <numeric>
 #include <random>
+#include <set>
 #include <ranges>
+#include <thread>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
-void print(const auto &container) {
-	for(const auto value : container) {
-		std::cout << int(value) << " ";
-	}
-	std::cout << std::endl;
-}
-
-template<class T>
-void printrange(T from, const T to) {
-	while (from != to) {
-		std::cout << int(*from) << " ";
-		++from;
-	}
-	std::cout << std::endl;
-}
-
-
-template<class ForwardIt>
-void quicksort(ForwardIt first, ForwardIt last)
-{
-	std::cout << "before: ";
-	printrange(first, last);
-    if (first == last)
-        return;
- 
-    auto pivot = *std::next(first, std::distance(first, last) / 2);
-    std::cout << "pivot: " << int(pivot) << std::endl;
-    auto middle1 = std::partition(first, last, [pivot](const auto& em)
-    {
-        return em < pivot;
-    });
-    std::cout << "partition1: ";
-	printrange(first, last);
-    auto middle2 = std::partition(middle1, last, [pivot](const auto& em)
-    {
-        return !(pivot < em);
-    });
-    std::cout << "M1, M2: " << int(*middle1) << ", " << int(*middle2) << std::endl;
-	std::cout << "partition: ";
-	printrange(first, last);
- 
-    quicksort(first, middle1);
-    quicksort(middle2, last);
-
-	std::cout << "after: ";
-	printrange(first, last);
-}
-
-template<class ForwardIt>
-void xxx(ForwardIt first, ForwardIt last) {
-    std::cout << "before: "; printrange(first, last);
-    int pivot = *std::next(first, std::distance(first, last) / 2);
-    std::cout << "pivot: " << int(pivot) << std::endl;
-    auto middle1 = std::partition(first, last, [pivot](const auto& em){ return em < pivot; });
-    std::cout <<  int(*middle1) << std::endl;
-    std::cout << "partition1: "; printrange(middle1, last);
-    auto middle2 = std::partition(middle1, last, [pivot](const auto& em){
-      std::cout << int(pivot) << " " << int(em) << " " << (!(pivot < em)) << std::endl;
-      return !(pivot < em);
-    });
-    std::cout << "M1, M2: " << int(*middle1) << ", " << int(*middle2) << std::endl;
-    std::cout << "partition: ";
-    printrange(first, last);
-}
-
-
-void list_push_back(auto& slist, const auto& value) {
-	auto before_end = slist.before_begin();
-	for ([[maybe_unused]]auto& _ : slist) {
-		++before_end;
-	}
-	slist.insert_after(before_end, value);
-}
-
-template<typename T, size_t value_limit, size_t max_size>
-void push_back_both(std::forward_list<T>& slist, compact_forward_list<value_limit, max_size> &clist, const T& value) {
-	auto before_end = slist.before_begin();
-	for ([[maybe_unused]]auto& _ : slist) {
-		++before_end;
-	}
-	slist.insert_after(before_end, value);
-
-	clist.push_back(value);
-}
-
 template<typename T, size_t value_limit, size_t max_size>
 void push_front_both(std::forward_list<T>& slist, compact_forward_list<value_limit, max_size> &clist, const T& value) {
 	slist.push_front(value);
@@ -126,155 +50,982 @@ void insert_all(auto& list, const auto& numbers) {
 	}
 }
 
-// TEST(LinkedListTest, CanHoldValue) {
-//   compact_forward_list<42, 6> l;
-//   l.push_back(4);
-//   ASSERT_EQ(*l.begin(), 4);
-// }
-
-// TEST(LinkedList, CanHoldMaximumValues) {
-// 	constexpr size_t max_values = 50;
-// 	compact_forward_list<max_values, 42> l;
-// 	const std::vector<int> numbers = shuffled_sequence(max_values);
-
-// 	for(const int num : std::ranges::reverse_view(numbers)) {
-// 		l.push_front(num);
-// 	}
-
-// 	ASSERT_THAT(l, ::testing::ElementsAreArray(numbers));
-// }
-
-
-// TEST(LinkedListTest, SameAsForwardList) {
-//   compact_forward_list<42, 42> l;
-//   std::forward_list<int> fl;
-
-//   std::vector<int> numbers(6) ; // vector with 100 ints.
-//   std::iota(std::begin(numbers), std::end(numbers), 0); // Fill with 0, 1, ..., 99.
-//   std::mt19937 gen;
-//   std::shuffle(numbers.begin(), numbers.end(), gen);
-//   for(const int num : numbers) {
-//   	l.push_front(num);
-//   	fl.push_front(num);
-//   }
-//   ASSERT_THAT(fl, ::testing::ElementsAreArray(l));
-//   print(l);
-//   print(fl);
-//   quicksort(l.begin(), l.end());
-//   std::cout << "SORT SECOND" << std::endl;
-//   quicksort(fl.begin(), fl.end());
-//   // fl.sort();
-//   print(l);
-//   print(fl);
-
-//   ASSERT_THAT(fl, ::testing::ElementsAreArray(l));
-// }
-
-TEST(Partition, failing) {
-  std::vector<int> arr({4, 5, 1, 3, 2});
-  std::reverse(arr.begin(), arr.end());
+TEST(LinkedListTest, CanHoldValue) {
+  compact_forward_list<42, 6> l;
+  l.push_back(4);
+  ASSERT_EQ(*l.begin(), 4);
+}
+
+TEST(LinkedListTest, CanHoldMaximumValues) {
+  constexpr size_t max_values = 50;
+  compact_forward_list<max_values, max_values> l;
+  const std::vector<int> numbers = shuffled_sequence(max_values);
+  insert_all(l, numbers);
+  ASSERT_THAT(l, ::testing::ElementsAreArray(numbers));
+}
+
+TEST(LinkedListTest, SameAsForwardList) {
+  compact_forward_list<42, 42> l;
+  std::forward_list<int> fl;
+  std::mt19937 gen(9);
+  for(int round = 0; round < 1000; round++) {
+    const int value = gen() % 42;
+    switch(gen() % 4) {
+      case 0:
+        if (!fl.empty()) {
+          pop_front_both(fl, l);
+        }
+        break;
+      case 1:
+        if (std::distance(fl.begin(), fl.end()) < 42) {
+          push_front_both(fl, l, value);
+        }
+        break;
+      case 2:
+        if (std::distance(fl.begin(), fl.end()) > 1) {
+          const size_t position = gen() % (std::distance(fl.begin(), fl.end()) - 1);
+          fl.erase_after(std::next(fl.begin(), position));
+          l.erase_after(std::next(l.begin(), position));
+        }
+        break;
+      default:
+        if (!fl.empty() && std::distance(fl.begin(), fl.end()) < 42) {
+          const size_t position = gen() % std::distance(fl.begin(), fl.end());
+          fl.insert_after(std::next(fl.begin(), position), value);
+          l.insert_after(std::next(l.begin(), position), value);
+        }
+    }
+    ASSERT_TRUE(are_lists_equal(fl, l));
+  }
+}
+
+// push_back goes through the tail index, so it is used after every operation that can move the tail
+TEST(LinkedListTest, TailStaysCorrectAsForwardList) {
+  constexpr int capacity = 20;
+  compact_forward_list<42, capacity> l;
+  std::forward_list<int> fl;
+  std::mt19937 gen(10);
+  for(int round = 0; round < 5000; round++) {
+    const int value = gen() % 42;
+    const int size = std::distance(fl.begin(), fl.end());
+    switch(gen() % 8) {
+      case 0:
+        //Insert after the last element
+        if (size > 0 && size < capacity) {
+          fl.insert_after(std::next(fl.begin(), size-1), value);
+          l.insert_after(std::next(l.begin(), size-1), value);
+        }
+        break;
+      case 1:
+        //Erase the last element
+        if (size > 0) {
+          fl.erase_after(std::next(fl.before_begin(), size-1));
+          l.erase_after(std::next(l.before_begin(), size-1));
+        }
+        break;
+      case 2:
+        //Pop until the list is empty
+        while(!fl.empty()) {
+          pop_front_both(fl, l);
+        }
+        break;
+      case 3:
+        fl.clear();
+        l.clear();
+        break;
+      case 4:
+        if (size > 0 && gen() % 2) {
+          pop_front_both(fl, l);
+        } else if (size < capacity) {
+          push_front_both(fl, l, value);
+        }
+        break;
+      case 5:
+        fl.reverse();
+        l.reverse();
+        break;
+      case 6:
+        fl.remove(value % 4);
+        l.remove(value % 4);
+        break;
+      default:
+        break;
+    }
+    if (std::distance(fl.begin(), fl.end()) < capacity) {
+      fl.insert_after(std::next(fl.before_begin(), std::distance(fl.begin(), fl.end())), value);
+      l.push_back(value);
+    }
+    ASSERT_TRUE(are_lists_equal(fl, l)) << round;
+  }
+}
+
+TEST(LinkedListTest, FullAfterMaxSizeElements) {
+  compact_forward_list<42, 3> l;
+  dynamic_compact_forward_list dynamic(42, 3);
+  compact_list<42, 3> xor_list;
+  for(int i = 0; i < 3; i++) {
+    ASSERT_FALSE(l.full());
+    ASSERT_FALSE(dynamic.full());
+    ASSERT_FALSE(xor_list.full());
+    l.push_back(i);
+    dynamic.push_front(i);
+    xor_list.push_back(i);
+  }
+  ASSERT_TRUE(l.full());
+  ASSERT_TRUE(dynamic.full());
+  ASSERT_TRUE(xor_list.full());
+#ifndef NDEBUG
+  EXPECT_DEATH(l.push_front(5), "no free node left");
+  EXPECT_DEATH(l.insert_after(l.begin(), 5), "no free node left");
+  EXPECT_DEATH(dynamic.push_back(5), "no free node left");
+  EXPECT_DEATH(xor_list.push_front(5), "no free node left");
+#endif
+  l.pop_front();
+  ASSERT_FALSE(l.full());
+  l.push_back(5);
+  ASSERT_THAT(l, ::testing::ElementsAre(1, 2, 5));
+}
+
+TEST(LinkedListTest, ProxySwapAndAssign) {
+  compact_forward_list<42, 42> l;
+  l.assign(std::vector<int>{1, 2, 3, 4});
+  swap(*l.begin(), *std::next(l.begin(), 3));
+  ASSERT_THAT(l, ::testing::ElementsAre(4, 2, 3, 1));
+  *std::next(l.begin()) = *std::next(l.begin(), 2);
+  ASSERT_THAT(l, ::testing::ElementsAre(4, 3, 3, 1));
+  std::iter_swap(l.begin(), std::next(l.begin()));
+  ASSERT_THAT(l, ::testing::ElementsAre(3, 4, 3, 1));
+}
+
+TEST(BulkOperations, SortMatchesForwardList) {
+  const std::vector<int> numbers = shuffled_sequence(40);
+  std::forward_list<int> fl(numbers.begin(), numbers.end());
+  compact_forward_list<42, 42> l;
+  l.assign(numbers);
+
+  fl.sort();
+  l.sort();
+  ASSERT_TRUE(are_lists_equal(fl, l));
+
+  l.push_back(41);
+  fl.insert_after(std::next(fl.before_begin(), 40), 41);
+  ASSERT_TRUE(are_lists_equal(fl, l));
+}
+
+TEST(BulkOperations, SortIsStable) {
+  compact_forward_list<16, 42> l;
+  l.assign(std::vector<int>{9, 3, 12, 1, 7, 3, 15});
+  l.sort([](const auto first, const auto second){ return first % 4 < second % 4; });
+  ASSERT_THAT(l, ::testing::ElementsAre(12, 9, 1, 3, 7, 3, 15));
+}
+
+TEST(BulkOperations, ReverseRemoveUnique) {
+  compact_forward_list<42, 42> l;
+  l.assign(std::vector<int>{1, 1, 2, 3, 3, 3, 4, 1});
+  EXPECT_EQ(l.unique(), 3u);
+  ASSERT_THAT(l, ::testing::ElementsAre(1, 2, 3, 4, 1));
+  EXPECT_EQ(l.remove(1), 2u);
+  ASSERT_THAT(l, ::testing::ElementsAre(2, 3, 4));
+  l.reverse();
+  ASSERT_THAT(l, ::testing::ElementsAre(4, 3, 2));
+  l.push_back(5);
+  ASSERT_THAT(l, ::testing::ElementsAre(4, 3, 2, 5));
+  EXPECT_EQ(l.remove_if([](const auto value){ return value > 2; }), 3u);
+  ASSERT_THAT(l, ::testing::ElementsAre(2));
+}
+
+TEST(BulkOperations, MergeAndSplice) {
+  compact_forward_list<42, 42> l;
+  compact_forward_list<42, 42> other;
+  l.assign(std::vector<int>{1, 4, 9});
+  other.assign(std::vector<int>{2, 4, 10, 11});
+  l.merge(other);
+  ASSERT_TRUE(other.empty());
+  ASSERT_THAT(l, ::testing::ElementsAre(1, 2, 4, 4, 9, 10, 11));
+
+  other.assign(std::vector<int>{30, 31});
+  l.splice_after(std::next(l.begin()), other);
+  ASSERT_THAT(l, ::testing::ElementsAre(1, 2, 30, 31, 4, 4, 9, 10, 11));
+
+  l.splice_after(l.before_begin(), l, std::next(l.begin(), 7));
+  ASSERT_THAT(l, ::testing::ElementsAre(11, 1, 2, 30, 31, 4, 4, 9, 10));
+  l.push_back(20);
+  ASSERT_THAT(l, ::testing::ElementsAre(11, 1, 2, 30, 31, 4, 4, 9, 10, 20));
+}
+
+TEST(Compaction, KeepsOrderAndFreeNodes) {
+  std::mt19937 gen(3);
+  std::forward_list<int> fl;
+  compact_forward_list<1000, 300> l;
+  for(int round = 0; round < 2000; round++) {
+    if (gen() % 3 == 0 && !fl.empty()) {
+      fl.pop_front();
+      l.pop_front();
+    } else if (std::distance(fl.begin(), fl.end()) < 300) {
+      const int value = gen() % 1000;
+      fl.push_front(value);
+      l.push_front(value);
+    }
+  }
+  l.compact();
+  ASSERT_TRUE(are_lists_equal(fl, l));
+
+  std::vector<int> visited;
+  l.for_each([&](const auto value){ visited.push_back(value); });
+  ASSERT_THAT(visited, ::testing::ElementsAreArray(fl));
+
+  const size_t size = std::distance(fl.begin(), fl.end());
+  for(size_t i = size; i < 300; i++) {
+    l.push_back(i % 1000);
+    fl.insert_after(std::next(fl.before_begin(), i), i % 1000);
+  }
+  l.compact();
+  ASSERT_TRUE(are_lists_equal(fl, l));
+  l.pop_front();
+  l.push_front(7);
+  fl.front() = 7;
+  ASSERT_TRUE(are_lists_equal(fl, l));
+}
+
+TEST(Compaction, ForEachFollowsLinks) {
+  compact_forward_list<(1ull << 20), 100> l;
+  l.assign(std::vector<int>{5, 1, 900000, 3, 4});
+  l.reverse();
+  l.splice_after(l.begin(), l, std::next(l.begin(), 2));
+  std::vector<int> visited;
+  l.for_each([&](const auto value){ visited.push_back(value); });
+  ASSERT_THAT(visited, ::testing::ElementsAre(4, 1, 3, 900000, 5));
+  l.compact();
+  visited.clear();
+  l.for_each([&](const auto value){ visited.push_back(value); });
+  ASSERT_THAT(visited, ::testing::ElementsAre(4, 1, 3, 900000, 5));
+}
+
+TEST(CompactVector, RandomAccess) {
+  compact_vector<1000, 100> v;
+  ASSERT_TRUE(v.empty());
+  for(int i = 0; i < 100; i++) {
+    v.push_back(i*7 % 1000);
+  }
+  ASSERT_EQ(v.size(), 100u);
+  EXPECT_EQ(v[13], 91);
+  v[13] = 999;
+  EXPECT_EQ(v[13], 999);
+  EXPECT_EQ(v[12], 84);
+  EXPECT_EQ(v[14], 98);
+  v.pop_back();
+  ASSERT_EQ(v.size(), 99u);
+  EXPECT_EQ(*std::next(v.begin(), 98), 686);
+}
+
+template <size_t value_limit>
+void check_bulk_conversion() {
+  std::mt19937 gen(4);
+  constexpr size_t size = 1000;
+  compact_vector<value_limit, size> v;
+  std::vector<uint32_t> values(size);
+  for(auto& value : values) {
+    value = gen() % value_limit;
+  }
+  v.assign(values.data(), 300);
+  v.pack(300, size-300, values.data()+300);
+  ASSERT_EQ(v.size(), size);
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), v.begin(), v.end()));
+
+  //Unaligned ranges and blocks next to each other
+  for(const auto& [first, count] : {std::pair<size_t, size_t>{0, size}, {3, 5}, {5, 17}, {8, 64}, {999, 1}, {1, 998}}) {
+    std::vector<uint32_t> unpacked(count);
+    v.unpack(first, count, unpacked.data());
+    ASSERT_TRUE(std::equal(unpacked.begin(), unpacked.end(), values.begin()+first));
+
+    for(auto& value : unpacked) {
+      value = gen() % value_limit;
+    }
+    v.pack(first, count, unpacked.data());
+    std::copy(unpacked.begin(), unpacked.end(), values.begin()+first);
+    ASSERT_TRUE(std::equal(values.begin(), values.end(), v.begin(), v.end()));
+  }
+}
+
+TEST(CompactVector, BulkConversion) {
+  check_bulk_conversion<2>();
+  check_bulk_conversion<42>();
+  check_bulk_conversion<1000>();
+  check_bulk_conversion<(1 << 20)>();
+  check_bulk_conversion<(1ull << 32)>();
+}
+
+template <size_t value_limit, size_t max_size>
+void check_dynamic_list() {
+  std::mt19937_64 gen(6);
+  compact_forward_list<value_limit, max_size> expected;
+  dynamic_compact_forward_list l(value_limit, max_size);
+  ASSERT_EQ(l.buffer_bytes(), expected.required_bytes);
+  size_t size = 0;
+  for(int round = 0; round < 1000; round++) {
+    const uint64_t value = gen() % value_limit;
+    if (gen() % 3 == 0 && size > 0) {
+      expected.pop_front();
+      l.pop_front();
+      size--;
+    } else if (size < max_size) {
+      expected.push_back(value);
+      l.push_back(value);
+      size++;
+    }
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), l.begin(), l.end()));
+  }
+  std::vector<uint64_t> visited;
+  l.for_each([&](const auto value){ visited.push_back(value); });
+  ASSERT_TRUE(std::equal(expected.begin(), expected.end(), visited.begin(), visited.end()));
+}
+
+TEST(DynamicList, MatchesCompileTimeList) {
+  check_dynamic_list<2, 10>();
+  check_dynamic_list<1000, 100>();
+  check_dynamic_list<(1ull << 20), 300>();
+  check_dynamic_list<(1ull << 60), 50>();
+  EXPECT_THROW(dynamic_compact_forward_list(10, 0), std::invalid_argument);
+}
+
+TEST(DynamicList, MovedFromListStaysUsable) {
+  dynamic_compact_forward_list l(100, 10);
+  l.push_back(1);
+  l.push_back(2);
+  dynamic_compact_forward_list moved = std::move(l);
+  ASSERT_TRUE(l.empty());
+  ASSERT_EQ(l.capacity(), 10);
+  l.push_back(3);
+  l.push_front(4);
+  ASSERT_THAT(l, ::testing::ElementsAre(4, 3));
+  ASSERT_THAT(moved, ::testing::ElementsAre(1, 2));
+
+  dynamic_compact_forward_list other(1000, 20);
+  other.push_back(999);
+  other = std::move(l);
+  ASSERT_THAT(other, ::testing::ElementsAre(4, 3));
+  ASSERT_EQ(l.capacity(), 20);
+  ASSERT_THAT(l, ::testing::ElementsAre(999));
+  l.clear();
+  l.push_back(5);
+  ASSERT_THAT(l, ::testing::ElementsAre(5));
+}
+
+TEST(SpscQueue, SingleThreadFifo) {
+  compact_spsc_queue<1000, 10> queue;
+  uint16_t value;
+  ASSERT_FALSE(queue.try_pop(value));
+  for(int round = 0; round < 5; round++) {
+    for(int i = 0; i < 10; i++) {
+      ASSERT_TRUE(queue.try_push(round*100 + i));
+    }
+    ASSERT_FALSE(queue.try_push(1));
+    for(int i = 0; i < 10; i++) {
+      ASSERT_TRUE(queue.try_pop(value));
+      ASSERT_EQ(value, round*100 + i);
+    }
+  }
+  const uint16_t values[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  ASSERT_EQ(queue.try_push(values, 12), 10u);
+  uint16_t popped[12];
+  ASSERT_EQ(queue.try_pop(popped, 12), 10u);
+  ASSERT_TRUE(std::equal(popped, popped+10, values));
+}
+
+TEST(SpscQueue, TwoThreadsKeepOrder) {
+  constexpr uint32_t value_limit = 1u << 20;
+  constexpr size_t count = 200000;
+  auto queue = std::make_unique<compact_spsc_queue<value_limit, 1000>>();
+  std::thread producer([&]{
+    uint32_t batch[37];
+    for(size_t i = 0; i < count;) {
+      if (i % 3 == 0) {
+        while(!queue->try_push(i % value_limit)) {
+        }
+        i++;
+      } else {
+        const size_t batch_size = std::min<size_t>(37, count-i);
+        for(size_t j = 0; j < batch_size; j++) {
+          batch[j] = (i+j) % value_limit;
+        }
+        for(size_t pushed = 0; pushed < batch_size;) {
+          pushed += queue->try_push(batch+pushed, batch_size-pushed);
+        }
+        i += batch_size;
+      }
+    }
+  });
+  size_t received = 0;
+  bool in_order = true;
+  uint32_t batch[29];
+  while(received < count) {
+    const size_t popped = queue->try_pop(batch, 29);
+    for(size_t j = 0; j < popped; j++) {
+      in_order = in_order && batch[j] == (received+j) % value_limit;
+    }
+    received += popped;
+  }
+  producer.join();
+  ASSERT_TRUE(in_order);
+  ASSERT_TRUE(queue->empty());
+}
 
+template <template <size_t, size_t, size_t> class layout_policy>
+void check_layout() {
+  std::mt19937 gen(8);
   std::forward_list<int> fl;
+  compact_forward_list<(1 << 16), 500, heap_storage, layout_policy> l;
+  for(int round = 0; round < 2000; round++) {
+    if (gen() % 3 == 0 && !fl.empty()) {
+      fl.pop_front();
+      l.pop_front();
+    } else if (std::distance(fl.begin(), fl.end()) < 500) {
+      const int value = gen() % (1 << 16);
+      fl.push_front(value);
+      l.push_front(value);
+    }
+  }
+  ASSERT_TRUE(std::equal(fl.begin(), fl.end(), l.begin(), l.end()));
+  fl.sort();
+  l.sort();
+  l.compact();
+  std::vector<int> visited;
+  l.for_each([&](const auto value){ visited.push_back(value); });
+  ASSERT_THAT(visited, ::testing::ElementsAreArray(fl));
+}
+
+TEST(Layout, AllLayoutsBehaveTheSame) {
+  check_layout<interleaved_layout>();
+  check_layout<planar_layout>();
+  check_layout<padded_layout>();
+  check_layout<auto_layout>();
+}
+
+TEST(Layout, CostModelChoices) {
+  //Small lists keep nodes together, a list far larger than the cache prefers the index plane
+  static_assert(std::is_base_of_v<interleaved_layout<10, 10, 1000>, auto_layout<10, 10, 1000>>);
+  static_assert(std::is_base_of_v<planar_layout<20, 21, (1 << 20)>, auto_layout<20, 21, (1 << 20)>>);
+  //Padding 30 bits to 32 makes both fields byte aligned
+  static_assert(std::is_base_of_v<padded_layout<24, 6, 40>, auto_layout<24, 6, 40>>);
+  //6+6 bit nodes padded to 16 bits, the 18 header bits padded to 32
+  static_assert(compact_forward_list<42, 42, heap_storage, padded_layout>::required_bytes == (32 + 42*16)/8);
+}
+
+TEST(Storage, InlineListHasNoHeapBuffer) {
+  using list_type = compact_forward_list<42, 42, inline_storage>;
+  static_assert(sizeof(list_type) == list_type::required_bytes);
+  list_type l;
+  insert_all(l, std::vector<int>{1, 2, 3});
+  ASSERT_THAT(l, ::testing::ElementsAre(1, 2, 3));
+}
+
+TEST(Storage, ExternalBufferHoldsTheList) {
+  using list_type = compact_forward_list<42, 42, external_storage>;
+  std::vector<std::byte> buffer(list_type::required_bytes);
+  {
+    list_type l(buffer.data());
+    insert_all(l, std::vector<int>{4, 5, 6});
+  }
+  list_type other(buffer.data());
+  ASSERT_EQ(other.begin(), other.end());
+}
+
+TEST(Storage, CopyIsDeep) {
+  compact_forward_list<42, 42> l;
+  insert_all(l, std::vector<int>{7, 8, 9});
+  compact_forward_list<42, 42> copy = l;
+  copy.pop_front();
+  ASSERT_THAT(l, ::testing::ElementsAre(7, 8, 9));
+  ASSERT_THAT(copy, ::testing::ElementsAre(8, 9));
+
+  copy = l;
+  ASSERT_TRUE(copy == l);
+
+  compact_forward_list<42, 42> moved = std::move(copy);
+  ASSERT_THAT(moved, ::testing::ElementsAre(7, 8, 9));
+}
+
+TEST(Storage, MovedFromListsStayUsable) {
+  compact_forward_list<42, 42> l;
+  insert_all(l, std::vector<int>{7, 8, 9});
+  compact_forward_list<42, 42> moved = std::move(l);
+  ASSERT_TRUE(l.empty());
+  l.push_back(5);
+  l.push_front(4);
+  ASSERT_THAT(l, ::testing::ElementsAre(4, 5));
+  ASSERT_THAT(moved, ::testing::ElementsAre(7, 8, 9));
+
+  //Move assignment swaps, the source holds the previous list of the target
+  moved = std::move(l);
+  ASSERT_THAT(moved, ::testing::ElementsAre(4, 5));
+  ASSERT_THAT(l, ::testing::ElementsAre(7, 8, 9));
+  l.clear();
+  ASSERT_TRUE(l.empty());
+
+  std::vector<compact_forward_list<42, 42>> lists(3);
+  lists[0].push_back(1);
+  lists.erase(lists.begin());
+  lists.emplace_back();
+  ASSERT_TRUE(std::all_of(lists.begin(), lists.end(), [](const auto& list){ return list.empty(); }));
+
+  compact_forward_list<42, 42, inline_storage> inline_list;
+  inline_list.push_back(3);
+  compact_forward_list<42, 42, inline_storage> inline_moved = std::move(inline_list);
+  ASSERT_TRUE(inline_list.empty());
+  inline_list.push_back(6);
+  ASSERT_THAT(inline_list, ::testing::ElementsAre(6));
+  ASSERT_THAT(inline_moved, ::testing::ElementsAre(3));
+
+  compact_list<42, 42> xor_list;
+  xor_list.push_back(1);
+  compact_list<42, 42> xor_moved = std::move(xor_list);
+  ASSERT_TRUE(xor_list.empty());
+  xor_list.push_back(2);
+  ASSERT_THAT(xor_list, ::testing::ElementsAre(2));
+  ASSERT_THAT(xor_moved, ::testing::ElementsAre(1));
+
+  compact_list_pool<42, 10, 2> pool;
+  pool.push_front(1, 1);
+  compact_list_pool<42, 10, 2> pool_moved = std::move(pool);
+  ASSERT_TRUE(pool.empty(1));
+  pool.push_front(0, 2);
+  ASSERT_EQ(pool.front(0), 2);
+  ASSERT_EQ(pool_moved.front(1), 1);
+
+  compact_vector<42, 42> vector;
+  vector.push_back(1);
+  compact_vector<42, 42> vector_moved = std::move(vector);
+  ASSERT_TRUE(vector.empty());
+  vector.push_back(2);
+  ASSERT_EQ(vector.size(), 1);
+  ASSERT_EQ(vector_moved[0], 1);
+
+  compact_sorted_list<1000, 100> sorted;
+  sorted.insert(10);
+  compact_sorted_list<1000, 100> sorted_moved = std::move(sorted);
+  ASSERT_EQ(sorted.size(), 0);
+  sorted.insert(20);
+  ASSERT_TRUE(sorted.contains(20));
+  ASSERT_FALSE(sorted.contains(10));
+  ASSERT_TRUE(sorted_moved.contains(10));
+}
+
+TEST(Storage, CopyAssignmentIntoExternalBuffer) {
+  using list_type = compact_forward_list<42, 42, external_storage>;
+  std::vector<std::byte> first_buffer(list_type::required_bytes);
+  std::vector<std::byte> second_buffer(list_type::required_bytes);
+  list_type first(first_buffer.data());
+  list_type second(second_buffer.data());
+  insert_all(first, std::vector<int>{1, 41});
+  second = first;
+  first.pop_front();
+  ASSERT_THAT(second, ::testing::ElementsAre(1, 41));
+}
+
+TEST(Serialization, DeserializeRestoresTheList) {
+  using list_type = compact_forward_list<1000, 100, heap_storage, planar_layout>;
+  list_type l;
+  insert_all(l, std::vector<int>{999, 0, 500});
+  l.erase_after(l.begin());
+  std::vector<std::byte> buffer(list_type::serialized_bytes);
+  ASSERT_EQ(l.serialize(buffer), list_type::serialized_bytes);
+
+  list_type copy = list_type::deserialize(buffer);
+  ASSERT_TRUE(copy == l);
+  //The free list comes along as well
+  copy.push_front(7);
+  ASSERT_THAT(copy, ::testing::ElementsAre(7, 999, 500));
+}
+
+TEST(Serialization, ViewAdoptsTheBuffer) {
+  compact_forward_list<42, 42, inline_storage> l;
+  insert_all(l, std::vector<int>{1, 2, 3});
+  std::vector<std::byte> buffer(decltype(l)::serialized_bytes);
+  l.serialize(buffer);
+
+  compact_forward_list_view<42, 42> view(adopt_serialized, buffer);
+  ASSERT_THAT(view, ::testing::ElementsAre(1, 2, 3));
+  view.pop_front();
+  compact_forward_list_view<42, 42> second_view(adopt_serialized, buffer);
+  ASSERT_THAT(second_view, ::testing::ElementsAre(2, 3));
+}
+
+TEST(Serialization, HeaderMismatchThrows) {
   compact_forward_list<42, 42> l;
+  std::vector<std::byte> buffer(decltype(l)::serialized_bytes);
+  ASSERT_THROW(l.serialize(std::span(buffer).first(10)), std::invalid_argument);
+  l.serialize(buffer);
+
+  ASSERT_THROW((compact_forward_list<100, 42>::deserialize(buffer)), std::invalid_argument);
+  ASSERT_THROW((compact_forward_list<42, 100>::deserialize(buffer)), std::invalid_argument);
+  ASSERT_THROW((compact_forward_list<42, 42, heap_storage, padded_layout>::deserialize(buffer)), std::invalid_argument);
+  ASSERT_THROW((compact_forward_list_view<42, 42>(adopt_serialized, std::span(buffer).first(20))), std::invalid_argument);
+  buffer[0] = std::byte{0};
+  ASSERT_THROW((compact_forward_list_view<42, 42>(adopt_serialized, buffer)), std::invalid_argument);
+}
+
+TEST(Serialization, UnusedBytesAreZero) {
+  using inline_list = compact_forward_list<1000, 100, inline_storage>;
+  using heap_list = compact_forward_list<1000, 100>;
+  std::vector<std::byte> expected(inline_list::serialized_bytes);
+  {
+    inline_list l;
+    l.push_back(5);
+    l.serialize(expected);
+  }
+
+  //Storage that held other data before the list was created
+  alignas(inline_list) std::byte raw[sizeof(inline_list)];
+  std::memset(raw, 0xFF, sizeof(raw));
+  inline_list* in_place = new (raw) inline_list;
+  in_place->push_back(5);
+  std::vector<std::byte> buffer(inline_list::serialized_bytes);
+  in_place->serialize(buffer);
+  in_place->~inline_list();
+  ASSERT_EQ(buffer, expected);
+
+  {
+    std::unique_ptr<std::byte[]> dirty(new std::byte[heap_list::required_bytes]);
+    std::memset(dirty.get(), 0xFF, heap_list::required_bytes);
+  }
+  heap_list on_heap;
+  on_heap.push_back(5);
+  on_heap.serialize(buffer);
+  ASSERT_EQ(buffer, expected);
+}
+
+TEST(Serialization, RoundTripAfterRandomOperations) {
+  using list_type = compact_forward_list<42, 30, heap_storage, padded_layout>;
+  list_type l;
+  std::forward_list<int> fl;
+  std::mt19937 gen(11);
+  std::vector<std::byte> buffer(list_type::serialized_bytes);
+  for(int round = 0; round < 2000; round++) {
+    const int value = gen() % 42;
+    const int size = std::distance(fl.begin(), fl.end());
+    switch(gen() % 7) {
+      case 0:
+        if (size < 30) {
+          fl.push_front(value);
+          l.push_front(value);
+        }
+        break;
+      case 1:
+        if (size < 30) {
+          fl.insert_after(std::next(fl.before_begin(), size), value);
+          l.push_back(value);
+        }
+        break;
+      case 2:
+        if (size > 0) {
+          const int position = gen() % size;
+          fl.erase_after(std::next(fl.before_begin(), position));
+          l.erase_after(std::next(l.before_begin(), position));
+        }
+        break;
+      case 3:
+        fl.sort();
+        l.sort();
+        break;
+      case 4:
+        fl.unique();
+        l.unique();
+        break;
+      case 5:
+        l.compact();
+        break;
+      default:
+        fl.remove(value % 8);
+        l.remove(value % 8);
+        break;
+    }
+    l.serialize(buffer);
+    list_type copy = list_type::deserialize(buffer);
+    ASSERT_TRUE(std::equal(fl.begin(), fl.end(), copy.begin(), copy.end())) << round;
+    compact_forward_list_view<42, 30, padded_layout> view(adopt_serialized, buffer);
+    ASSERT_TRUE(std::equal(view.begin(), view.end(), copy.begin(), copy.end())) << round;
+  }
+}
+
+TEST(Serialization, CorruptedLinksThrow) {
+  //Planar layout with 8-bit indices: free, tail and first index in the first bytes after the
+  //header, then the next index of node i in byte 2+i
+  using list_type = compact_forward_list<256, 200, heap_storage, planar_layout>;
+  constexpr size_t header = 16;
+  list_type l;
+  insert_all(l, std::vector<int>{10, 20, 30});
+  l.erase_after(l.begin());
+  ASSERT_THAT(l, ::testing::ElementsAre(10, 30));
+  std::vector<std::byte> valid(list_type::serialized_bytes);
+  l.serialize(valid);
+  ASSERT_NO_THROW(list_type::deserialize(valid));
+
+  //insert_all pushes to the front, so the list is node 3 (10) -> node 1 (30) and erased node 2 heads the free list
+  auto corrupted = [&](const size_t position, const int value) {
+    std::vector<std::byte> buffer = valid;
+    buffer[header+position] = std::byte(value);
+    return buffer;
+  };
+  const std::vector<std::vector<std::byte>> cases{
+    corrupted(2+1, 3),    // cycle 3 -> 1 -> 3
+    corrupted(1, 3),      // tail is not the last element
+    corrupted(2+3, 250),  // next index past max_size
+    corrupted(0, 1),      // free list starts inside the list
+    corrupted(2+2, 0),    // free list claims nodes from 3 on were never used
+  };
+  for(const auto& buffer : cases) {
+    ASSERT_THROW(list_type::deserialize(buffer), std::invalid_argument);
+    std::vector<std::byte> adopted = buffer;
+    ASSERT_THROW((compact_forward_list_view<256, 200, planar_layout>(adopt_serialized, adopted)), std::invalid_argument);
+  }
+}
+
+TEST(SortedList, InsertKeepsOrderWithoutDuplicates) {
+  compact_sorted_list<1000, 100> l;
+  for(const int value : {500, 3, 999, 3, 0, 42}) {
+    l.insert(value);
+  }
+  ASSERT_THAT(l, ::testing::ElementsAre(0, 3, 42, 500, 999));
+  ASSERT_EQ(l.size(), 5);
+  ASSERT_FALSE(l.insert(42));
+  ASSERT_TRUE(l.contains(999));
+  ASSERT_FALSE(l.contains(998));
+  ASSERT_TRUE(l.erase(0));
+  ASSERT_FALSE(l.erase(0));
+  ASSERT_THAT(l, ::testing::ElementsAre(3, 42, 500, 999));
+}
+
+TEST(SortedList, SameAsSet) {
+  compact_sorted_list<(1ull << 40), 2000> l;
+  std::set<uint64_t> s;
+  std::mt19937_64 gen(7);
+  for(int i = 0; i < 20000; i++) {
+    //Runs of consecutive ids with an occasional large gap
+    const uint64_t value = gen() % 8 == 0 ? gen() % (1ull << 40) : gen() % 3000;
+    if (gen() % 3 != 0 && s.size() < l.capacity()) {
+      ASSERT_EQ(l.insert(value), s.insert(value).second);
+    } else {
+      ASSERT_EQ(l.erase(value), s.erase(value) == 1);
+    }
+    ASSERT_EQ(l.contains(value), s.count(value) == 1);
+  }
+  ASSERT_EQ(l.size(), s.size());
+  ASSERT_TRUE(std::equal(l.begin(), l.end(), s.begin(), s.end()));
+  std::vector<uint64_t> values;
+  l.for_each([&](const uint64_t value) { values.push_back(value); });
+  ASSERT_TRUE(std::equal(values.begin(), values.end(), s.begin(), s.end()));
+}
+
+TEST(SortedList, HoldsCapacityValues) {
+  compact_sorted_list<(1ull << 32), 1000> l;
+  std::mt19937_64 gen(8);
+  std::set<uint64_t> s;
+  //Every 64th gap is as large as possible, the rest are 1
+  for(uint64_t value = 0; s.size() < l.capacity(); value += s.size() % 64 == 0 ? (1ull << 32)/20 : 1) {
+    s.insert(value);
+  }
+  std::vector<uint64_t> values(s.begin(), s.end());
+  std::shuffle(values.begin(), values.end(), gen);
+  for(const auto value : values) {
+    l.insert(value);
+  }
+  ASSERT_TRUE(std::equal(l.begin(), l.end(), s.begin(), s.end()));
+  for(const auto value : values) {
+    ASSERT_TRUE(l.erase(value));
+  }
+  ASSERT_TRUE(l.empty());
+  ASSERT_EQ(l.begin(), l.end());
+}
+
+TEST(SortedList, SmallerThanCompactVector) {
+  static_assert(compact_sorted_list<(1 << 16), 4000>::required_bytes < compact_vector<(1 << 16), 4000>::required_bytes);
+  static_assert(compact_sorted_list<(1ull << 32), 4000>::required_bytes < compact_vector<(1ull << 32), 4000>::required_bytes);
+}
+
+TEST(XorList, SameBufferSizeAsForwardList) {
+  static_assert(compact_list<1000, 1000>::required_bytes == compact_forward_list<1000, 1000>::required_bytes);
+  static_assert(compact_list<(1ull << 40), 4000>::required_bytes == compact_forward_list<(1ull << 40), 4000>::required_bytes);
+}
+
+TEST(XorList, IteratesBothWays) {
+  compact_list<100, 10> l;
+  for(const int value : {1, 2, 3}) {
+    l.push_back(value);
+  }
+  l.push_front(0);
+  ASSERT_THAT(l, ::testing::ElementsAre(0, 1, 2, 3));
+  ASSERT_THAT(std::vector<int>(l.rbegin(), l.rend()), ::testing::ElementsAre(3, 2, 1, 0));
+  ASSERT_EQ(l.front(), 0);
+  ASSERT_EQ(l.back(), 3);
+
+  l.reverse();
+  ASSERT_THAT(l, ::testing::ElementsAre(3, 2, 1, 0));
+  l.pop_back();
+  l.pop_front();
+  ASSERT_THAT(l, ::testing::ElementsAre(2, 1));
+  *l.begin() = 99;
+  ASSERT_THAT(std::as_const(l), ::testing::ElementsAre(99, 1));
+}
+
+TEST(XorList, EraseAndInsertAtIterator) {
+  compact_list<100, 10> l;
+  for(int i = 0; i < 10; i++) {
+    l.push_back(i);
+  }
+  //Erases the odd values while walking backwards
+  for(auto it = std::prev(l.end()); it != l.begin();) {
+    if (*it % 2 == 1) {
+      it = std::prev(l.erase(it));
+    } else {
+      --it;
+    }
+  }
+  ASSERT_THAT(l, ::testing::ElementsAre(0, 2, 4, 6, 8));
+  auto it = l.insert(std::next(l.begin(), 2), 3);
+  ASSERT_EQ(*it, 3);
+  ASSERT_EQ(*std::prev(it), 2);
+  ASSERT_EQ(*std::next(it), 4);
+  l.insert(l.end(), 9);
+  ASSERT_THAT(l, ::testing::ElementsAre(0, 2, 3, 4, 6, 8, 9));
+}
+
+TEST(XorList, SameAsList) {
+  compact_list<1000, 300> l;
+  std::list<int> s;
+  std::mt19937 gen(9);
+  for(int i = 0; i < 20000; i++) {
+    const size_t size = s.size();
+    const size_t position = size == 0 ? 0 : gen() % (size+1);
+    const int value = gen() % 1000;
+    switch(gen() % 5) {
+      case 0:
+      case 1:
+        if (size < 300) {
+          l.insert(std::next(l.begin(), position), value);
+          s.insert(std::next(s.begin(), position), value);
+        }
+        break;
+      case 2:
+        if (position < size) {
+          l.erase(std::next(l.begin(), position));
+          s.erase(std::next(s.begin(), position));
+        }
+        break;
+      case 3:
+        l.reverse();
+        s.reverse();
+        break;
+      case 4:
+        if (size != 0 && size < 300) {
+          l.pop_back();
+          l.push_front(value);
+          s.pop_back();
+          s.push_front(value);
+        }
+        break;
+    }
+    ASSERT_TRUE(std::equal(l.begin(), l.end(), s.begin(), s.end()));
+    ASSERT_TRUE(std::equal(l.rbegin(), l.rend(), s.rbegin(), s.rend()));
+  }
+}
+
+
+TEST(ListPool, ListsShareNodes) {
+  compact_list_pool<100, 10, 3> pool;
+  for(int i = 0; i < 10; i++) {
+    pool.push_front(i % 3, i);
+  }
+  ASSERT_TRUE(pool.full());
+  ASSERT_THAT(std::vector<int>(pool.begin(0), pool.end(0)), ::testing::ElementsAre(9, 6, 3, 0));
+  ASSERT_THAT(std::vector<int>(pool.begin(1), pool.end(1)), ::testing::ElementsAre(7, 4, 1));
+
+  pool.splice_front(2, 0);
+  ASSERT_THAT(std::vector<int>(pool.begin(0), pool.end(0)), ::testing::ElementsAre(6, 3, 0));
+  ASSERT_THAT(std::vector<int>(pool.begin(2), pool.end(2)), ::testing::ElementsAre(9, 8, 5, 2));
+
+  pool.clear(1);
+  ASSERT_TRUE(pool.empty(1));
+  for(int i = 0; i < 3; i++) {
+    pool.push_front(1, 50+i);
+  }
+  ASSERT_TRUE(pool.full());
+  ASSERT_THAT(std::vector<int>(pool.begin(1), pool.end(1)), ::testing::ElementsAre(52, 51, 50));
+  ASSERT_THAT(std::vector<int>(pool.begin(2), pool.end(2)), ::testing::ElementsAre(9, 8, 5, 2));
+}
+
+#ifndef NDEBUG
+TEST(ListPool, PushIntoFullPoolAsserts) {
+  compact_list_pool<100, 4, 2> pool;
+  for(int i = 0; i < 4; i++) {
+    pool.push_front(i % 2, i);
+  }
+  ASSERT_TRUE(pool.full());
+  EXPECT_DEATH(pool.push_front(0, 5), "no free node left");
+}
+#endif
 
-  for(const int num : arr) {
-    fl.push_front(num);
-    l.push_front(num);
+TEST(ListPool, MatchesForwardLists) {
+  constexpr size_t list_count = 17;
+  compact_list_pool<1000, 200, list_count> pool;
+  std::vector<std::forward_list<int>> reference(list_count);
+  std::mt19937 gen(3);
+  size_t size = 0;
+  for(int step = 0; step < 20000; step++) {
+    const size_t list = gen() % list_count;
+    const size_t other = gen() % list_count;
+    switch(gen() % 3) {
+      case 0:
+        if (size < 200) {
+          const int value = gen() % 1000;
+          pool.push_front(list, value);
+          reference[list].push_front(value);
+          size++;
+        }
+        break;
+      case 1:
+        if (!reference[list].empty()) {
+          ASSERT_EQ(pool.front(list), reference[list].front());
+          pool.pop_front(list);
+          reference[list].pop_front();
+          size--;
+        }
+        break;
+      default:
+        if (!reference[list].empty()) {
+          pool.splice_front(other, list);
+          reference[other].splice_after(reference[other].before_begin(), reference[list], reference[list].before_begin());
+        }
+    }
+  }
+  for(size_t list = 0; list < list_count; list++) {
+    ASSERT_TRUE(std::equal(pool.begin(list), pool.end(list), reference[list].begin(), reference[list].end()));
   }
-  print(fl);
-  print(l);
-
-  std::cout << std::endl << "NORMAL LIST:" << std::endl;
-  xxx(fl.begin(), fl.end());
-  std::cout << std::endl << "MY LIST:" << std::endl;
-  xxx(l.begin(), l.end());
-
-  std::vector<bool> arrbool(10);
-  arrbool[0] = 1;
-  auto it = arrbool.begin();
-  auto elem = *it;
-  // elem = std::string{"sadfs"};
-  std::cout << elem << std::endl;
-  arrbool[0] = 0;
-  std::cout << elem << std::endl;
-}
-
-
-// template <typename T>
-// class LinkedListCapacity : public testing::Test {};
-
-// template<size_t val>
-// struct Wrapper {
-// 	static constexpr size_t value = val;
-// };
-
-// using TestingSizes = ::testing::Types<Wrapper<8>, Wrapper<16>, Wrapper<32>, Wrapper<64>, Wrapper<128>, Wrapper<256>, Wrapper<512>, Wrapper<1024>, Wrapper<2048>, Wrapper<65536>>;
-// TYPED_TEST_SUITE(LinkedListCapacity, TestingSizes);
-
-// TYPED_TEST(LinkedListCapacity, CanHoldUpToPowerOf2) {
-// 	const size_t size = TypeParam::value;
-// 	compact_forward_list<size, size> list;
-// 	const std::vector<int> numbers = shuffled_sequence(size-1);
-// 	// print(numbers);
-// 	for(const int num : std::ranges::reverse_view(numbers)) {
-// 		list.push_front(num);
-// 	}
-
-// 	ASSERT_THAT(list, ::testing::ElementsAreArray(numbers));
-// }
-
-// TYPED_TEST(LinkedListCapacity, CanHoldPowerOf2) {
-// 	const size_t size = TypeParam::value+1;
-// 	compact_forward_list<size, size> list;
-// 	const std::vector<int> numbers = shuffled_sequence(size-1);
-// 	// print(numbers);
-// 	for(const int num : std::ranges::reverse_view(numbers)) {
-// 		list.push_front(num);
-// 	}
-
-// 	ASSERT_THAT(list, ::testing::ElementsAreArray(numbers));
-// }
-
-
-// int main(int argc, char const *argv[]) {
-// 	compact_forward_list<42, 6> l;
-// 	std::forward_list<int> fl;
-
-// 	push_back_both(fl, l, 7);
-// 	push_back_both(fl, l, 11);
-// 	push_back_both(fl, l, 22);
-// 	push_back_both(fl, l, 3);
-	
-// 	print(l);
-// 	print(fl);
-// 	assert(are_lists_equal(fl, l));
-// 	pop_front_both(fl, l);
-// 	pop_front_both(fl, l);
-// 	pop_front_both(fl, l);
-// 	pop_front_both(fl, l);
-
-// 	push_back_both(fl, l, 5);
-// 	push_back_both(fl, l, 6);
-// 	push_back_both(fl, l, 7);
-// 	print(l);
-// 	print(fl);
-// 	assert(are_lists_equal(fl, l));
-
-
-// 	l.printbegnum();
-// 	push_back_both(fl, l, 20);
-// 	push_back_both(fl, l, 40);
-// 	push_back_both(fl, l, 1);
-// 	print(l);
-// 	print(fl);
-// 	l.printbegnum();
-// 	assert(are_lists_equal(fl, l));
-
-// 	quicksort(l.begin(), l.end());
-// 	fl.sort();
-// 	print(l);
-// 	print(fl);
-// 	assert(are_lists_equal(fl, l));
-
-// 	return 0;
-// }
+}
+
+
+template <typename T>
+class LinkedListCapacity : public testing::Test {};
+
+template<size_t val>
+struct Wrapper {
+  static constexpr size_t value = val;
+};
+
+using TestingSizes = ::testing::Types<Wrapper<8>, Wrapper<16>, Wrapper<32>, Wrapper<64>, Wrapper<128>, Wrapper<256>, Wrapper<512>, Wrapper<1024>, Wrapper<2048>, Wrapper<65536>>;
+TYPED_TEST_SUITE(LinkedListCapacity, TestingSizes);
+
+TYPED_TEST(LinkedListCapacity, CanHoldUpToPowerOf2) {
+  const size_t size = TypeParam::value;
+  compact_forward_list<size, size> list;
+  const std::vector<int> numbers = shuffled_sequence(size);
+  insert_all(list, numbers);
+  ASSERT_THAT(list, ::testing::ElementsAreArray(numbers));
+}
+
+TYPED_TEST(LinkedListCapacity, CanHoldPowerOf2PlusOne) {
+  const size_t size = TypeParam::value+1;
+  compact_forward_list<size, size> list;
+  const std::vector<int> numbers = shuffled_sequence(size);
+  insert_all(list, numbers);
+  ASSERT_THAT(list, ::testing::ElementsAreArray(numbers));
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// Monoids usable as per-component aggregates of aggregate_union_find. A monoid supplies the
+// value type, the neutral element and an associative (and here also commutative) operation.
+template <typename T>
+struct sum_monoid {
+    using value_type = T;
+    static constexpr T identity() noexcept { return T{0}; }
+    static constexpr T combine(const T first, const T second) noexcept { return first + second; }
+};
+
+template <typename T>
+struct min_monoid {
+    using value_type = T;
+    static constexpr T identity() noexcept { return std::numeric_limits<T>::max(); }
+    static constexpr T combine(const T first, const T second) noexcept { return std::min(first, second); }
+};
+
+template <typename T>
+struct max_monoid {
+    using value_type = T;
+    static constexpr T identity() noexcept { return std::numeric_limits<T>::lowest(); }
+    static constexpr T combine(const T first, const T second) noexcept { return std::max(first, second); }
+};
+
+// Union-find that keeps a monoid aggregate for each component, combined on merge. With
+// track_members the members of every component form a circular list that is spliced in O(1)
+// on merge, so listing a component costs its size.
+template <typename Monoid, bool track_members = false>
+class aggregate_union_find {
+public:
+    using value_type = typename Monoid::value_type;
+
+private:
+    std::vector<int> roots;
+    std::vector<int> sizes;
+    std::vector<value_type> aggregates;
+    std::vector<int> next_member;
+    int groups_count;
+
+public:
+    aggregate_union_find(const int max_count) : aggregate_union_find(std::vector<value_type>(max_count, Monoid::identity())) {
+    }
+
+    aggregate_union_find(std::vector<value_type> values) : roots(values.size()), sizes(values.size(), 1), aggregates(std::move(values)), groups_count(static_cast<int>(roots.size())) {
+        std::iota(std::begin(roots), std::end(roots), 0);
+        if constexpr (track_members) {
+            next_member.resize(roots.size());
+            std::iota(std::begin(next_member), std::end(next_member), 0);
+        }
+    }
+
+    int find(int idx) noexcept {
+        //Find root index
+        int root_idx = idx;
+        while(root_idx != roots[root_idx]) {
+            root_idx = roots[root_idx];
+        }
+
+        //Reconnect all elements to root
+        while (idx != root_idx) {
+            const int next_idx = roots[idx];
+            roots[idx] = root_idx;
+            idx = next_idx;
+        }
+
+        return root_idx;
+    }
+
+    bool merge(const int first, const int second) noexcept {
+        int first_idx = find(first);
+        int second_idx = find(second);
+
+        if (first_idx == second_idx) {
+            return true;
+        }
+
+        groups_count--;
+
+        if(sizes[first_idx] > sizes[second_idx]){
+            std::swap(first_idx, second_idx);
+        }
+
+        roots[first_idx] = second_idx;
+        sizes[second_idx] += sizes[first_idx];
+        aggregates[second_idx] = Monoid::combine(aggregates[second_idx], aggregates[first_idx]);
+
+        if constexpr (track_members) {
+            //Swapping successors of two elements of distinct cycles joins the cycles
+            std::swap(next_member[first_idx], next_member[second_idx]);
+        }
+
+        return false;
+    }
+
+    // Aggregate of the component, the argument has to be a root (result of find)
+    const value_type& aggregate(const int root_idx) const noexcept {
+        return aggregates[root_idx];
+    }
+
+    // Folds value into the aggregate of the component containing idx
+    void add_value(const int idx, const value_type& value) noexcept {
+        const int root_idx = find(idx);
+        aggregates[root_idx] = Monoid::combine(aggregates[root_idx], value);
+    }
+
+    int get_group_size(const int idx) noexcept {
+        return sizes[find(idx)];
+    }
+
+    template <typename F>
+    void for_each_member(const int idx, F&& f) const requires track_members {
+        int member = idx;
+        do {
+            f(member);
+            member = next_member[member];
+        } while (member != idx);
+    }
+
+    std::vector<int> members(const int idx) const requires track_members {
+        std::vector<int> result;
+        for_each_member(idx, [&result](const int member){ result.push_back(member); });
+        return result;
+    }
+
+    int get_groups_count() const noexcept {
+        return groups_count;
+    }
+};
@@ -0,0 +1,164 @@
+#include "union_find.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+// Usage: benchmark [max_element_count = 10^9] [query_count = 10^7]
+// Element counts go from 10^3 up to max_element_count in powers of 10.
+
+template <typename F>
+double measure(F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+void report(const std::string& name, const long long element_count, const double seconds, const size_t operation_count) {
+    std::cout << std::setw(16) << name << std::setw(12) << element_count << std::setw(12) << std::fixed << std::setprecision(2) << seconds*1e9/operation_count << " ns/op" << std::endl;
+}
+
+struct xorshift {
+    uint64_t state = 88172645463325252ull;
+    uint64_t operator()() noexcept {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+// Calls f(first, second) for every merge of the pattern, returns the number of merges
+template <typename F>
+size_t for_each_merge(const std::string& pattern, const int element_count, F&& f) {
+    if (pattern == "random") {
+        xorshift gen;
+        for(int i = 0; i < element_count; i++) {
+            f(static_cast<int>(gen() % element_count), static_cast<int>(gen() % element_count));
+        }
+        return element_count;
+    }
+    if (pattern == "chain") {
+        for(int i = 1; i < element_count; i++) {
+            f(i-1, i);
+        }
+        return element_count-1;
+    }
+    if (pattern == "star") {
+        for(int i = 1; i < element_count; i++) {
+            f(0, i);
+        }
+        return element_count-1;
+    }
+    //Grid - right and bottom neighbour of every cell
+    const int side = static_cast<int>(std::sqrt(element_count));
+    size_t count = 0;
+    for(int row = 0; row < side; row++) {
+        for(int column = 0; column < side; column++) {
+            const int cell = row*side + column;
+            if (column+1 < side) {
+                f(cell, cell+1);
+                count++;
+            }
+            if (row+1 < side) {
+                f(cell, cell+side);
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void benchmark_patterns(const int element_count, const size_t query_count) {
+    for(const std::string pattern : {"random", "chain", "star", "grid"}) {
+        union_find sets(element_count);
+        size_t merge_count = 0;
+        const double merge_seconds = measure([&]{
+            merge_count = for_each_merge(pattern, element_count, [&sets](const int first, const int second){
+                sets.merge(first, second);
+            });
+        });
+        report(std::string(pattern).append(" merge"), element_count, merge_seconds, merge_count);
+
+        long long checksum = 0;
+        xorshift gen;
+        const double find_seconds = measure([&]{
+            for(size_t i = 0; i < query_count; i++) {
+                checksum += sets.find(static_cast<int>(gen() % element_count));
+            }
+        });
+        report(std::string(pattern).append(" find"), element_count, find_seconds, query_count);
+        if (checksum == -1) {
+            std::cout << checksum;
+        }
+    }
+}
+
+void benchmark_batched(const int element_count, const size_t query_count) {
+    std::vector<std::pair<int, int>> merges(element_count/2);
+    std::vector<std::pair<int, int>> queries(query_count);
+    xorshift gen;
+    for(auto& [first, second] : merges) {
+        first = static_cast<int>(gen() % element_count);
+        second = static_cast<int>(gen() % element_count);
+    }
+    for(auto& [first, second] : queries) {
+        first = static_cast<int>(gen() % element_count);
+        second = static_cast<int>(gen() % element_count);
+    }
+    std::vector<int> indices(query_count);
+    for(size_t i = 0; i < query_count; i++) {
+        indices[i] = queries[i].first;
+    }
+
+    union_find single(element_count);
+    union_find batched(element_count);
+
+    report("merge", element_count, measure([&]{
+        for(const auto& [first, second] : merges) {
+            single.merge(first, second);
+        }
+    }), merges.size());
+    report("merge_many", element_count, measure([&]{
+        batched.merge_many(merges);
+    }), merges.size());
+
+    std::vector<int> results(query_count);
+    report("find", element_count, measure([&]{
+        for(size_t i = 0; i < query_count; i++) {
+            results[i] = single.find(indices[i]);
+        }
+    }), query_count);
+    report("find_many", element_count, measure([&]{
+        batched.find_many(indices, results);
+    }), query_count);
+
+    auto same = std::make_unique<bool[]>(query_count);
+    report("same_set", element_count, measure([&]{
+        for(size_t i = 0; i < query_count; i++) {
+            same[i] = single.find(queries[i].first) == single.find(queries[i].second);
+        }
+    }), query_count);
+    report("same_set_many", element_count, measure([&]{
+        batched.same_set_many(queries, {same.get(), query_count});
+    }), query_count);
+}
+
+int main(int argc, char const *argv[]) {
+    const long long max_element_count = argc > 1 ? std::stoll(argv[1]) : 1'000'000'000;
+    const size_t query_count = argc > 2 ? std::stoull(argv[2]) : 10'000'000;
+
+    for(long long element_count = 1'000; element_count <= max_element_count; element_count *= 10) {
+        benchmark_patterns(static_cast<int>(element_count), query_count);
+    }
+
+    std::cout << std::endl << "batched vs single calls" << std::endl;
+    benchmark_batched(static_cast<int>(max_element_count), query_count);
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "union_find.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Builds a partition of vertex_count elements with worker_count processes on one host (POSIX).
+// Every worker process fills its own local union_find from its shard of edges by calling
+// load_shard(worker_index, local). Vertex ids are global, so workers only exchange the vertices
+// their shard touched: the partitions are reconciled pairwise in log2(worker_count) rounds - in
+// round r worker w folds the (vertex, root) pairs of worker w + 2^r into its own union_find, and
+// a worker publishes the pairs of its non-root vertices into shared memory once it has merged
+// all its partners. Returns the root of every vertex in the global partition.
+// Each worker still holds a dense union_find over all vertex_count vertices (that is what
+// load_shard fills), only the exchange is sparse. The shared segment reserves room for
+// vertex_count pairs per worker without committing it, only published pairs use memory.
+template <typename ShardLoader>
+std::vector<int> distributed_partition(const int vertex_count, const int worker_count, ShardLoader&& load_shard) {
+    struct worker_state {
+        //Number of rounds the worker merged partners in, set once its pairs are published
+        std::atomic<int> finished_rounds;
+        std::atomic<bool> aborted;
+        size_t pair_count;
+    };
+    struct label_pair {
+        int vertex;
+        int root;
+    };
+    static_assert(std::atomic<int>::is_always_lock_free, "atomics in shared memory have to be lock free");
+
+    //A worker publishes at most one pair per non-root vertex, worker 0 never publishes
+    const size_t pairs_size = size_t(worker_count-1)*vertex_count*sizeof(label_pair);
+    const size_t segment_size = worker_count*sizeof(worker_state) + pairs_size;
+    void* segment = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (segment == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "mmap");
+    }
+    worker_state* states = static_cast<worker_state*>(segment);
+    for(int w = 0; w < worker_count; w++) {
+        new (&states[w]) worker_state{-1, false, 0};
+    }
+    //Any worker failing sets the flag of worker 0, which every waiting worker checks
+    std::atomic<bool>& aborted = states[0].aborted;
+    std::vector<pid_t> children;
+
+    //Worker 0 is the parent of all other workers, so it also notices workers killed by a signal
+    auto child_failed = [&children]{
+        for(const pid_t pid : children) {
+            siginfo_t info{};
+            if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid == pid && !(info.si_code == CLD_EXITED && info.si_status == 0)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    label_pair* const pairs = reinterpret_cast<label_pair*>(states + worker_count);
+    auto worker_pairs = [pairs, vertex_count](const int worker) {
+        return pairs + size_t(worker-1)*vertex_count;
+    };
+
+    //The calling process is worker 0, it ends up holding the global partition
+    std::vector<int> result;
+    auto run_worker = [&](const int worker) {
+        union_find local(vertex_count);
+        load_shard(worker, local);
+
+        //Only these vertices can have a root other than themselves: non-roots and the roots they
+        //hang from, later also every vertex named by a partner
+        std::vector<int> touched;
+        for(int v = 0; v < vertex_count; v++) {
+            const int root = local.find(v);
+            if (root != v) {
+                touched.push_back(v);
+                touched.push_back(root);
+            }
+        }
+
+        int round = 0;
+        for(int step = 1; step < worker_count && worker % (2*step) == 0; step *= 2, round++) {
+            const int partner = worker + step;
+            if (partner >= worker_count) {
+                continue;
+            }
+            while(states[partner].finished_rounds.load(std::memory_order_acquire) < round) {
+                if (aborted.load() || (worker == 0 && child_failed())) {
+                    throw std::runtime_error("distributed_partition: worker process failed");
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            const label_pair* const other = worker_pairs(partner);
+            for(size_t i = 0; i < states[partner].pair_count; i++) {
+                local.merge(other[i].vertex, other[i].root);
+                touched.push_back(other[i].vertex);
+                touched.push_back(other[i].root);
+            }
+        }
+
+        if (worker == 0) {
+            result.resize(vertex_count);
+            for(int v = 0; v < vertex_count; v++) {
+                result[v] = local.find(v);
+            }
+            return;
+        }
+        std::sort(std::begin(touched), std::end(touched));
+        touched.erase(std::unique(std::begin(touched), std::end(touched)), std::end(touched));
+        label_pair* const own = worker_pairs(worker);
+        size_t pair_count = 0;
+        for(const int v : touched) {
+            const int root = local.find(v);
+            if (root != v) {
+                own[pair_count++] = {v, root};
+            }
+        }
+        states[worker].pair_count = pair_count;
+        states[worker].finished_rounds.store(round, std::memory_order_release);
+    };
+
+    int spawn_error = 0;
+    for(int w = 1; w < worker_count; w++) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            int status = 0;
+            try {
+                run_worker(w);
+            } catch (...) {
+                aborted.store(true);
+                status = 1;
+            }
+            _exit(status);
+        }
+        if (pid < 0) {
+            spawn_error = errno;
+            break;
+        }
+        children.push_back(pid);
+    }
+
+    bool failed = spawn_error != 0;
+    if (!failed) {
+        try {
+            run_worker(0);
+        } catch (...) {
+            aborted.store(true);
+            failed = true;
+        }
+    }
+    for(const pid_t pid : children) {
+        if (failed) {
+            kill(pid, SIGKILL);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        failed = failed || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+
+    munmap(segment, segment_size);
+    if (spawn_error) {
+        throw std::system_error(spawn_error, std::generic_category(), "fork");
+    }
+    if (failed) {
+        throw std::runtime_error("distributed_partition: worker process failed");
+    }
+    return result;
+}
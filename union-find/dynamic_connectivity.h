@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Fully dynamic connectivity (Holm, de Lichtenberg, Thorup) - like union_find, but edges can be
+// removed again. Every edge has a level, F_i is the spanning forest of tree edges with level >= i
+// and each F_i is kept as Euler tours in treaps. Removing a tree edge searches for a replacement
+// among non-tree edges of the smaller half and raises the levels of the edges it had to inspect,
+// which gives O(log^2 n) amortized updates and O(log n) queries.
+class dynamic_connectivity {
+    // Treap node of an Euler tour, either a vertex occurrence (from == to) or an arc of a tree edge
+    struct node {
+        node* left = nullptr;
+        node* right = nullptr;
+        node* parent = nullptr;
+        uint32_t priority;
+        int size = 1;
+        int vertex_count;
+        int from;
+        int to;
+        bool has_nontree = false;
+        bool has_tree_edge = false;
+        bool subtree_nontree = false;
+        bool subtree_tree_edge = false;
+
+        bool is_vertex() const noexcept {
+            return from == to;
+        }
+    };
+
+    struct edge_info {
+        int level = 0;
+        bool tree = false;
+        std::vector<std::pair<node*, node*>> arcs;
+    };
+
+    std::deque<node> node_pool;
+    std::vector<node*> free_nodes;
+    std::vector<std::vector<node*>> vertex_nodes;
+    std::vector<std::unordered_map<int, std::unordered_set<int>>> nontree_edges;
+    std::unordered_map<uint64_t, edge_info> edges;
+    uint32_t random_state = 2463534242u;
+    int groups_count;
+
+    static int size(const node* n) noexcept {
+        return n ? n->size : 0;
+    }
+
+    static int vertex_count(const node* n) noexcept {
+        return n ? n->vertex_count : 0;
+    }
+
+    static void update(node* n) noexcept {
+        n->size = 1 + size(n->left) + size(n->right);
+        n->vertex_count = n->is_vertex() + vertex_count(n->left) + vertex_count(n->right);
+        n->subtree_nontree = n->has_nontree || (n->left && n->left->subtree_nontree) || (n->right && n->right->subtree_nontree);
+        n->subtree_tree_edge = n->has_tree_edge || (n->left && n->left->subtree_tree_edge) || (n->right && n->right->subtree_tree_edge);
+    }
+
+    //Recomputes aggregates of all ancestors after a change of the node's own flags
+    static void refresh(node* n) noexcept {
+        for(; n; n = n->parent) {
+            update(n);
+        }
+    }
+
+    static node* root(node* n) noexcept {
+        while(n->parent) {
+            n = n->parent;
+        }
+        return n;
+    }
+
+    static int position(const node* n) noexcept {
+        int result = size(n->left);
+        for(; n->parent; n = n->parent) {
+            if (n == n->parent->right) {
+                result += size(n->parent->left) + 1;
+            }
+        }
+        return result;
+    }
+
+    static node* join(node* first, node* second) noexcept {
+        if (!first) {
+            return second;
+        }
+        if (!second) {
+            return first;
+        }
+        if (first->priority > second->priority) {
+            first->right = join(first->right, second);
+            first->right->parent = first;
+            update(first);
+            return first;
+        }
+        second->left = join(first, second->left);
+        second->left->parent = second;
+        update(second);
+        return second;
+    }
+
+    //Splits the tour into the first count nodes and the rest
+    static std::pair<node*, node*> split(node* n, const int count) noexcept {
+        if (!n) {
+            return {nullptr, nullptr};
+        }
+        n->parent = nullptr;
+        if (size(n->left) >= count) {
+            const auto [first, second] = split(n->left, count);
+            n->left = second;
+            if (second) {
+                second->parent = n;
+            }
+            update(n);
+            return {first, n};
+        }
+        const auto [first, second] = split(n->right, count - size(n->left) - 1);
+        n->right = first;
+        if (first) {
+            first->parent = n;
+        }
+        update(n);
+        return {n, second};
+    }
+
+    node* make_node(const int from, const int to) {
+        node* n;
+        if (free_nodes.empty()) {
+            n = &node_pool.emplace_back();
+        } else {
+            n = free_nodes.back();
+            free_nodes.pop_back();
+            *n = node{};
+        }
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        n->priority = random_state;
+        n->from = from;
+        n->to = to;
+        update(n);
+        return n;
+    }
+
+    node* vertex_node(const int level, const int vertex) {
+        node*& n = vertex_nodes[level][vertex];
+        if (!n) {
+            n = make_node(vertex, vertex);
+        }
+        return n;
+    }
+
+    static uint64_t edge_key(const int first, const int second) noexcept {
+        return (uint64_t(std::min(first, second)) << 32) | uint32_t(std::max(first, second));
+    }
+
+    static void reroot(node* n) noexcept {
+        const auto [first, second] = split(root(n), position(n));
+        join(second, first);
+    }
+
+    std::pair<node*, node*> link(const int level, const int first, const int second) {
+        node* first_node = vertex_node(level, first);
+        node* second_node = vertex_node(level, second);
+        reroot(first_node);
+        reroot(second_node);
+        node* forward = make_node(first, second);
+        node* backward = make_node(second, first);
+        join(join(join(root(first_node), forward), root(second_node)), backward);
+        return {forward, backward};
+    }
+
+    void cut(node* forward, node* backward) {
+        int forward_position = position(forward);
+        int backward_position = position(backward);
+        if (forward_position > backward_position) {
+            std::swap(forward_position, backward_position);
+        }
+        //Tour is A arc B arc C, B becomes one tree and A C the other
+        const auto [before, rest] = split(root(forward), forward_position);
+        const auto [first_arc, middle_and_rest] = split(rest, 1);
+        const auto [middle, second_arc_and_rest] = split(middle_and_rest, backward_position - forward_position - 1);
+        const auto [second_arc, after] = split(second_arc_and_rest, 1);
+        join(before, after);
+        free_nodes.push_back(first_arc);
+        free_nodes.push_back(second_arc);
+    }
+
+    void update_nontree_flag(const int level, const int vertex) {
+        node* n = vertex_node(level, vertex);
+        const auto it = nontree_edges[level].find(vertex);
+        n->has_nontree = it != nontree_edges[level].end() && !it->second.empty();
+        refresh(n);
+    }
+
+    void add_nontree(const int level, const int first, const int second) {
+        nontree_edges[level][first].insert(second);
+        nontree_edges[level][second].insert(first);
+        update_nontree_flag(level, first);
+        update_nontree_flag(level, second);
+    }
+
+    void remove_nontree(const int level, const int first, const int second) {
+        for(const auto& [from, to] : {std::pair{first, second}, std::pair{second, first}}) {
+            auto it = nontree_edges[level].find(from);
+            it->second.erase(to);
+            if (it->second.empty()) {
+                nontree_edges[level].erase(it);
+            }
+            update_nontree_flag(level, from);
+        }
+    }
+
+    void add_tree_edge(edge_info& edge, const int first, const int second) {
+        for(int level = static_cast<int>(edge.arcs.size()); level <= edge.level; level++) {
+            edge.arcs.push_back(link(level, first, second));
+        }
+        node* marked = edge.arcs[edge.level].first;
+        marked->has_tree_edge = true;
+        refresh(marked);
+    }
+
+    static void collect_tree_edges(node* n, std::vector<node*>& result) {
+        if (!n || !n->subtree_tree_edge) {
+            return;
+        }
+        if (n->has_tree_edge) {
+            result.push_back(n);
+        }
+        collect_tree_edges(n->left, result);
+        collect_tree_edges(n->right, result);
+    }
+
+    static node* find_nontree_vertex(node* n) noexcept {
+        while(n && n->subtree_nontree) {
+            if (n->has_nontree) {
+                return n;
+            }
+            n = (n->left && n->left->subtree_nontree) ? n->left : n->right;
+        }
+        return nullptr;
+    }
+
+    //Searches level by level for an edge reconnecting the two halves of a removed tree edge
+    bool replace(const int first, const int second, const int edge_level) {
+        for(int level = edge_level; level >= 0; level--) {
+            node* small = root(vertex_node(level, first));
+            node* large = root(vertex_node(level, second));
+            if (small->vertex_count > large->vertex_count) {
+                std::swap(small, large);
+            }
+
+            //The smaller half has at most half the vertices allowed at this level, so its tree edges can move up
+            std::vector<node*> promoted;
+            collect_tree_edges(small, promoted);
+            for(node* arc : promoted) {
+                arc->has_tree_edge = false;
+                refresh(arc);
+                edge_info& edge = edges[edge_key(arc->from, arc->to)];
+                edge.level++;
+                add_tree_edge(edge, arc->from, arc->to);
+            }
+
+            while(node* vertex = find_nontree_vertex(small)) {
+                const int from = vertex->from;
+                const std::vector<int> neighbours(std::begin(nontree_edges[level][from]), std::end(nontree_edges[level][from]));
+                for(const int to : neighbours) {
+                    remove_nontree(level, from, to);
+                    edge_info& edge = edges[edge_key(from, to)];
+                    if (root(vertex_node(level, to)) != small) {
+                        edge.tree = true;
+                        add_tree_edge(edge, from, to);
+                        return true;
+                    }
+                    edge.level++;
+                    add_nontree(edge.level, from, to);
+                }
+            }
+        }
+        return false;
+    }
+
+public:
+    dynamic_connectivity(const int max_count) : vertex_nodes(std::bit_width(static_cast<unsigned>(max_count))+1, std::vector<node*>(max_count, nullptr)), nontree_edges(vertex_nodes.size()), groups_count(max_count) {
+        for(int vertex = 0; vertex < max_count; vertex++) {
+            vertex_node(0, vertex);
+        }
+    }
+
+    dynamic_connectivity(const dynamic_connectivity&) = delete;
+    dynamic_connectivity& operator=(const dynamic_connectivity&) = delete;
+
+    // Representative of the group, stays the same until the next merge or split
+    int find(const int idx) const noexcept {
+        node* n = root(vertex_nodes[0][idx]);
+        //Leftmost vertex occurrence of the tour
+        while(!(n->is_vertex() && vertex_count(n->left) == 0)) {
+            n = vertex_count(n->left) > 0 ? n->left : n->right;
+        }
+        return n->from;
+    }
+
+    bool same_set(const int first, const int second) const noexcept {
+        return root(vertex_nodes[0][first]) == root(vertex_nodes[0][second]);
+    }
+
+    int get_group_size(const int idx) const noexcept {
+        return root(vertex_nodes[0][idx])->vertex_count;
+    }
+
+    // Adds edge between first and second, returns true when they were already connected
+    bool merge(const int first, const int second) {
+        const bool connected = same_set(first, second);
+        if (first == second || edges.count(edge_key(first, second))) {
+            return connected;
+        }
+
+        edge_info& edge = edges[edge_key(first, second)];
+        if (connected) {
+            add_nontree(0, first, second);
+        } else {
+            edge.tree = true;
+            add_tree_edge(edge, first, second);
+            groups_count--;
+        }
+        return connected;
+    }
+
+    // Removes edge between first and second, returns true when they are not connected afterwards
+    bool split(const int first, const int second) {
+        const auto it = edges.find(edge_key(first, second));
+        if (it == edges.end()) {
+            return !same_set(first, second);
+        }
+
+        const edge_info edge = std::move(it->second);
+        edges.erase(it);
+        if (!edge.tree) {
+            remove_nontree(edge.level, first, second);
+            return false;
+        }
+
+        for(const auto& [forward, backward] : edge.arcs) {
+            cut(forward, backward);
+        }
+        if (replace(first, second, edge.level)) {
+            return false;
+        }
+        groups_count++;
+        return true;
+    }
+
+    int get_groups_count() const noexcept {
+        return groups_count;
+    }
+};
@@ -0,0 +1,101 @@
+#include "dynamic_connectivity.h"
+#include "union_find.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Usage: dynamic_connectivity_benchmark [vertex_count = 10^5] [edge_count = 2*vertex_count] [update_count = 10^5]
+// Every update removes a random edge, adds a random edge not in the graph and asks one
+// connectivity query.
+
+template <typename F>
+void measure(const std::string& name, const size_t update_count, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    const long long checksum = f();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    std::cout << name << ": " << seconds*1e6/update_count << " us/update (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char const *argv[]) {
+    const int vertex_count = argc > 1 ? std::stoi(argv[1]) : 100'000;
+    const size_t edge_count = argc > 2 ? std::stoull(argv[2]) : 2*vertex_count;
+    const size_t update_count = argc > 3 ? std::stoull(argv[3]) : 100'000;
+
+    if (vertex_count < 2 || edge_count >= size_t(vertex_count)*(vertex_count-1)/2) {
+        std::cerr << "edge_count has to be below the number of vertex pairs" << std::endl;
+        return 1;
+    }
+
+    //The graph stays simple during all updates: dynamic_connectivity ignores a repeated edge and
+    //removes it on the first split, a multigraph would make both benchmarks see different graphs
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> vertex(0, vertex_count-1);
+    std::set<std::pair<int, int>> present;
+    auto random_new_edge = [&]{
+        while(true) {
+            const int first = vertex(gen);
+            const int second = vertex(gen);
+            if (first != second && present.emplace(std::min(first, second), std::max(first, second)).second) {
+                return std::pair<int, int>(first, second);
+            }
+        }
+    };
+    std::vector<std::pair<int, int>> edges(edge_count);
+    for(auto& edge : edges) {
+        edge = random_new_edge();
+    }
+    //Update i replaces edge replaced[i] with added[i] and then queries queries[i]
+    std::vector<size_t> replaced(update_count);
+    std::vector<std::pair<int, int>> added(update_count);
+    std::vector<std::pair<int, int>> queries(update_count);
+    std::vector<std::pair<int, int>> current = edges;
+    for(size_t i = 0; i < update_count; i++) {
+        replaced[i] = gen() % edge_count;
+        auto& [first, second] = current[replaced[i]];
+        present.erase({std::min(first, second), std::max(first, second)});
+        added[i] = current[replaced[i]] = random_new_edge();
+        queries[i] = {vertex(gen), vertex(gen)};
+    }
+
+    std::cout << "vertices: " << vertex_count << ", edges: " << edge_count << ", updates: " << update_count << std::endl;
+
+    measure("dynamic connectivity", update_count, [&]{
+        dynamic_connectivity graph(vertex_count);
+        std::vector<std::pair<int, int>> current = edges;
+        for(const auto& [first, second] : current) {
+            graph.merge(first, second);
+        }
+        long long connected = 0;
+        for(size_t i = 0; i < update_count; i++) {
+            auto& edge = current[replaced[i]];
+            graph.split(edge.first, edge.second);
+            edge = added[i];
+            graph.merge(edge.first, edge.second);
+            connected += graph.same_set(queries[i].first, queries[i].second);
+        }
+        return connected;
+    });
+
+    //Rebuilding after every update is quadratic, so only a sample of updates is timed
+    const size_t rebuild_count = std::min<size_t>(update_count, 1000);
+    measure("rebuild union_find", rebuild_count, [&]{
+        std::vector<std::pair<int, int>> current = edges;
+        long long connected = 0;
+        for(size_t i = 0; i < rebuild_count; i++) {
+            current[replaced[i]] = added[i];
+            union_find sets(vertex_count);
+            for(const auto& [first, second] : current) {
+                sets.merge(first, second);
+            }
+            connected += sets.find(queries[i].first) == sets.find(queries[i].second);
+        }
+        return connected;
+    });
+
+    return 0;
+}
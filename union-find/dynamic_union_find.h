@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Growable variant of union_find - elements are added one by one via make_set().
+// Links are plain indices, so growing the arrays never has to touch existing links.
+// The largest index_type value is never an element index, make_set throws std::length_error
+// instead of handing it out.
+template <typename index_type = uint32_t>
+class dynamic_union_find {
+    static_assert(std::is_unsigned_v<index_type>, "index_type has to be an unsigned integer type");
+
+    std::vector<index_type> roots;
+    std::vector<index_type> sizes;
+    index_type groups_count = 0;
+
+public:
+    dynamic_union_find() = default;
+
+    explicit dynamic_union_find(const index_type initial_count) {
+        reserve(initial_count);
+        for(index_type i = 0; i < initial_count; i++) {
+            make_set();
+        }
+    }
+
+    void reserve(const index_type count) {
+        roots.reserve(count);
+        sizes.reserve(count);
+    }
+
+    index_type make_set() {
+        if (roots.size() >= std::numeric_limits<index_type>::max()) {
+            throw std::length_error("dynamic_union_find: index_type cannot hold more elements");
+        }
+        const index_type idx = static_cast<index_type>(roots.size());
+        roots.push_back(idx);
+        sizes.push_back(1);
+        groups_count++;
+        return idx;
+    }
+
+    index_type find(index_type idx) noexcept {
+        //Find root index
+        index_type root_idx = idx;
+        while(root_idx != roots[root_idx]) {
+            root_idx = roots[root_idx];
+        }
+
+        //Reconnect all elements to root
+        while (idx != root_idx) {
+            const index_type next_idx = roots[idx];
+            roots[idx] = root_idx;
+            idx = next_idx;
+        }
+
+        return root_idx;
+    }
+
+    bool merge(const index_type first, const index_type second) noexcept {
+        index_type first_idx = find(first);
+        index_type second_idx = find(second);
+
+        if (first_idx == second_idx) {
+            return true;
+        }
+
+        groups_count--;
+
+        if(sizes[first_idx] > sizes[second_idx]){
+            std::swap(first_idx, second_idx);
+        }
+
+        roots[first_idx] = second_idx;
+        sizes[second_idx] += sizes[first_idx];
+
+        return false;
+    }
+
+    index_type get_group_size(const index_type idx) noexcept {
+        return sizes[find(idx)];
+    }
+
+    index_type size() const noexcept {
+        return static_cast<index_type>(roots.size());
+    }
+
+    index_type get_groups_count() const noexcept {
+        return groups_count;
+    }
+};
+
+// Front end for sparse keys (hashes, ids, ...). Keys are mapped to dense indices of a
+// dynamic_union_find by a flat open-addressing table with linear probing. Rehashing the
+// table only moves slots, the union-find links are never touched.
+template <typename Key, typename index_type = uint32_t, typename Hash = std::hash<Key>>
+class hashed_union_find {
+    //make_set never hands out this index
+    static constexpr index_type empty_slot = static_cast<index_type>(-1);
+    static constexpr size_t initial_capacity = 16;
+
+    dynamic_union_find<index_type> sets;
+    std::vector<Key> keys;
+    std::vector<index_type> slots;
+    Hash hasher;
+
+    // Murmur3 finalizer - std::hash of integers is the identity, keys sharing their low bits
+    // (strided ids) would otherwise all start probing at the same slot
+    static size_t mix(uint64_t hash) noexcept {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 33;
+        return static_cast<size_t>(hash);
+    }
+
+    size_t slot_of(const Key& key) const noexcept {
+        const size_t mask = slots.size()-1;
+        size_t slot = mix(hasher(key)) & mask;
+        while(slots[slot] != empty_slot && !(keys[slots[slot]] == key)) {
+            slot = (slot+1) & mask;
+        }
+        return slot;
+    }
+
+    void grow() {
+        std::vector<index_type> old_slots(slots.empty() ? initial_capacity : 2*slots.size(), empty_slot);
+        std::swap(slots, old_slots);
+        for(const index_type idx : old_slots) {
+            if (idx != empty_slot) {
+                slots[slot_of(keys[idx])] = idx;
+            }
+        }
+    }
+
+public:
+    hashed_union_find() {
+        grow();
+    }
+
+    explicit hashed_union_find(const size_t expected_count) {
+        size_t capacity = initial_capacity;
+        while(capacity < 2*expected_count) {
+            capacity *= 2;
+        }
+        slots.assign(capacity, empty_slot);
+        keys.reserve(expected_count);
+        sets.reserve(static_cast<index_type>(expected_count));
+    }
+
+    // Returns dense index of the key, inserting it as a new singleton set if it is not present
+    index_type insert(const Key& key) {
+        if (2*(keys.size()+1) > slots.size()) {
+            grow();
+        }
+
+        const size_t slot = slot_of(key);
+        if (slots[slot] == empty_slot) {
+            const index_type idx = sets.make_set();
+            keys.push_back(key);
+            slots[slot] = idx;
+        }
+        return slots[slot];
+    }
+
+    bool contains(const Key& key) const noexcept {
+        return slots[slot_of(key)] != empty_slot;
+    }
+
+    index_type index_of(const Key& key) const noexcept {
+        return slots[slot_of(key)];
+    }
+
+    const Key& key_of(const index_type idx) const noexcept {
+        return keys[idx];
+    }
+
+    // Representative key of the group, unknown keys are inserted
+    Key find(const Key& key) {
+        return keys[sets.find(insert(key))];
+    }
+
+    bool merge(const Key& first, const Key& second) {
+        const index_type first_idx = insert(first);
+        const index_type second_idx = insert(second);
+        return sets.merge(first_idx, second_idx);
+    }
+
+    bool same_set(const Key& first, const Key& second) {
+        const size_t first_slot = slot_of(first);
+        const size_t second_slot = slot_of(second);
+        if (slots[first_slot] == empty_slot || slots[second_slot] == empty_slot) {
+            return first == second;
+        }
+        return sets.find(slots[first_slot]) == sets.find(slots[second_slot]);
+    }
+
+    index_type size() const noexcept {
+        return static_cast<index_type>(keys.size());
+    }
+
+    index_type get_groups_count() const noexcept {
+        return sets.get_groups_count();
+    }
+};
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Streaming ingestion of text edge lists ("from to" per line, '#' starts a comment line).
+// The file is memory-mapped and cut into chunks at line boundaries, parser threads turn chunks
+// into batches of edges with a SWAR integer parser and a bounded queue hands the batches to
+// the consumer, which blocks the parsers when it cannot keep up. Vertex ids have to fit in 32
+// bits, larger ids throw std::out_of_range.
+
+using edge_pair = std::pair<uint32_t, uint32_t>;
+
+struct ingest_options {
+    unsigned parser_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunk_size = 4 << 20;
+    size_t queue_capacity = 64;
+};
+
+struct ingest_stats {
+    size_t edges = 0;
+    size_t bytes = 0;
+    double seconds = 0;
+
+    double edges_per_second() const noexcept {
+        return seconds > 0 ? edges/seconds : 0;
+    }
+};
+
+template <typename T>
+class bounded_queue {
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::deque<T> items;
+    const size_t capacity;
+    size_t producers;
+    bool closed = false;
+
+public:
+    bounded_queue(const size_t capacity, const size_t producers) : capacity(capacity), producers(producers) {
+    }
+
+    // Returns false once the queue is closed, the item is dropped then
+    bool push(T item) {
+        std::unique_lock lock(mutex);
+        not_full.wait(lock, [this]{ return items.size() < capacity || closed; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // Drops the queued items and wakes everyone, push fails and pop returns nothing from now on
+    void close() {
+        std::lock_guard lock(mutex);
+        closed = true;
+        items.clear();
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    void producer_done() {
+        std::lock_guard lock(mutex);
+        producers--;
+        not_empty.notify_all();
+    }
+
+    // Empty once all producers are done and the queue is drained
+    std::optional<T> pop() {
+        std::unique_lock lock(mutex);
+        not_empty.wait(lock, [this]{ return !items.empty() || producers == 0 || closed; });
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return item;
+    }
+};
+
+namespace ingest_detail {
+    constexpr uint64_t broadcast(const uint8_t byte) noexcept {
+        return 0x0101010101010101ull * byte;
+    }
+
+    // Number of leading (in memory order) ASCII digits in the little-endian word
+    inline int digit_count(const uint64_t word) noexcept {
+        const uint64_t high_nibble = (word & broadcast(0xF0)) ^ broadcast(0x30);
+        const uint64_t high_nibble_plus_6 = ((word + broadcast(0x06)) & broadcast(0xF0)) ^ broadcast(0x30);
+        const uint64_t non_digits = high_nibble | high_nibble_plus_6;
+        return non_digits ? std::countr_zero(non_digits)/8 : 8;
+    }
+
+    // Value of the first count (1-8) digits of the little-endian word
+    inline uint64_t parse_digits(uint64_t word, const int count) noexcept {
+        word = (word - broadcast('0')) << (8*(8-count));
+        word = (word*10 + (word >> 8)) & 0x00FF00FF00FF00FFull;
+        word = (word*100 + (word >> 16)) & 0x0000FFFF0000FFFFull;
+        word = (word*10000 + (word >> 32)) & 0x00000000FFFFFFFFull;
+        return word;
+    }
+
+    inline uint64_t load_word(const char* position) noexcept {
+        uint64_t word;
+        std::memcpy(&word, position, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big) {
+            word = __builtin_bswap64(word);
+        }
+        return word;
+    }
+
+    inline bool is_digit(const char c) noexcept {
+        return c >= '0' && c <= '9';
+    }
+
+    // Parses the number starting at position, 8 digits per step while a full word is readable.
+    // A number that does not fit in 64 bits is read as UINT64_MAX.
+    inline uint64_t parse_number(const char*& position, const char* const file_end) noexcept {
+        constexpr uint64_t saturated = std::numeric_limits<uint64_t>::max();
+        uint64_t value = 0;
+        while(file_end-position >= 8) {
+            const uint64_t word = load_word(position);
+            const int count = digit_count(word);
+            if (count == 0) {
+                return value;
+            }
+            constexpr uint64_t powers[9] = {1, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000};
+            const uint64_t digits = parse_digits(word, count);
+            value = value > (saturated-digits)/powers[count] ? saturated : value*powers[count] + digits;
+            position += count;
+            if (count < 8) {
+                return value;
+            }
+        }
+        while(position != file_end && is_digit(*position)) {
+            const uint64_t digit = *position-'0';
+            value = value > (saturated-digit)/10 ? saturated : value*10 + digit;
+            position++;
+        }
+        return value;
+    }
+
+    // Parses all lines in [begin, end), end is either the end of file or just after a newline.
+    // Throws std::out_of_range for an id that does not fit in 32 bits.
+    inline void parse_chunk(const char* position, const char* const end, const char* const file_end, std::vector<edge_pair>& edges) {
+        while(position != end) {
+            if (*position == '#' || *position == '%') {
+                position = static_cast<const char*>(std::memchr(position, '\n', end-position));
+                position = position ? position+1 : end;
+                continue;
+            }
+
+            uint64_t numbers[2];
+            int parsed = 0;
+            while(position != end && *position != '\n') {
+                if (is_digit(*position)) {
+                    const uint64_t value = parse_number(position, file_end);
+                    if (parsed < 2) {
+                        numbers[parsed] = value;
+                    }
+                    parsed++;
+                } else {
+                    position++;
+                }
+            }
+            if (position != end) {
+                position++;
+            }
+            if (parsed >= 2) {
+                if (std::max(numbers[0], numbers[1]) > std::numeric_limits<uint32_t>::max()) {
+                    throw std::out_of_range("edge list: vertex id " + std::to_string(std::max(numbers[0], numbers[1])) + " does not fit in 32 bits");
+                }
+                edges.emplace_back(static_cast<uint32_t>(numbers[0]), static_cast<uint32_t>(numbers[1]));
+            }
+        }
+    }
+
+    class mapped_file {
+        const char* begin_ = nullptr;
+        size_t size_ = 0;
+
+    public:
+        explicit mapped_file(const std::string& path) {
+            const int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "open " + path);
+            }
+            struct stat info;
+            if (fstat(fd, &info) != 0) {
+                close(fd);
+                throw std::system_error(errno, std::generic_category(), "fstat " + path);
+            }
+            size_ = info.st_size;
+            if (size_ > 0) {
+                void* address = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address == MAP_FAILED) {
+                    close(fd);
+                    throw std::system_error(errno, std::generic_category(), "mmap " + path);
+                }
+                madvise(address, size_, MADV_SEQUENTIAL);
+                begin_ = static_cast<const char*>(address);
+            }
+            close(fd);
+        }
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        ~mapped_file() {
+            if (begin_) {
+                munmap(const_cast<char*>(begin_), size_);
+            }
+        }
+
+        const char* begin() const noexcept { return begin_; }
+        const char* end() const noexcept { return begin_+size_; }
+        size_t size() const noexcept { return size_; }
+    };
+}
+
+// Parses the edge list in parallel and calls sink(std::span<const edge_pair>) with every batch
+// from the calling thread. Batches arrive in no particular order. An exception of a parser or of
+// the sink stops the parsers and is rethrown, some batches may have been passed to sink by then.
+template <typename Sink>
+ingest_stats ingest_edges(const std::string& path, Sink&& sink, const ingest_options& options = {}) {
+    const auto start = std::chrono::steady_clock::now();
+    const ingest_detail::mapped_file file(path);
+
+    //Chunk boundaries are moved just after the next newline
+    std::vector<const char*> boundaries{file.begin()};
+    while(boundaries.back() != file.end()) {
+        const char* boundary = boundaries.back() + std::min(options.chunk_size, static_cast<size_t>(file.end()-boundaries.back()));
+        if (boundary != file.end()) {
+            const void* newline = std::memchr(boundary, '\n', file.end()-boundary);
+            boundary = newline ? static_cast<const char*>(newline)+1 : file.end();
+        }
+        boundaries.push_back(boundary);
+    }
+
+    const unsigned parser_count = std::max(1u, options.parser_threads);
+    bounded_queue<std::vector<edge_pair>> queue(options.queue_capacity, parser_count);
+    std::atomic<size_t> next_chunk{0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const auto fail = [&](std::exception_ptr exception) {
+        {
+            std::lock_guard lock(error_mutex);
+            if (!error) {
+                error = std::move(exception);
+            }
+        }
+        queue.close();
+    };
+
+    std::vector<std::thread> parsers;
+    for(unsigned t = 0; t < parser_count; t++) {
+        parsers.emplace_back([&]{
+            try {
+                for(size_t chunk = next_chunk++; chunk+1 < boundaries.size(); chunk = next_chunk++) {
+                    std::vector<edge_pair> edges;
+                    edges.reserve((boundaries[chunk+1]-boundaries[chunk])/8);
+                    ingest_detail::parse_chunk(boundaries[chunk], boundaries[chunk+1], file.end(), edges);
+                    if (!queue.push(std::move(edges))) {
+                        break;
+                    }
+                }
+            } catch(...) {
+                fail(std::current_exception());
+            }
+            queue.producer_done();
+        });
+    }
+
+    ingest_stats stats;
+    stats.bytes = file.size();
+    try {
+        while(auto batch = queue.pop()) {
+            stats.edges += batch->size();
+            sink(std::span<const edge_pair>(*batch));
+        }
+    } catch(...) {
+        fail(std::current_exception());
+    }
+
+    for(auto& parser : parsers) {
+        parser.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return stats;
+}
+
+// Merges every edge of the file into sets (union_find or any type with merge(first, second))
+// of vertex_count elements. An id of vertex_count or more throws std::out_of_range, the edges
+// before it may have been merged.
+template <typename UnionFind>
+ingest_stats ingest_edges_into(const std::string& path, UnionFind& sets, const size_t vertex_count, const ingest_options& options = {}) {
+    return ingest_edges(path, [&sets, vertex_count](const std::span<const edge_pair> edges){
+        for(const auto& [first, second] : edges) {
+            if (std::max(first, second) >= vertex_count) {
+                throw std::out_of_range("edge list: vertex id " + std::to_string(std::max(first, second)) + " is not below the vertex count " + std::to_string(vertex_count));
+            }
+            sets.merge(first, second);
+        }
+    }, options);
+}
@@ -0,0 +1,33 @@
+#include "edge_ingest.h"
+#include "union_find.h"
+
+#include <iostream>
+
+// Usage: ingest <edge list file> <vertex count> [parser threads]
+int main(int argc, char const *argv[]) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <edge list file> <vertex count> [parser threads]" << std::endl;
+        return 1;
+    }
+
+    ingest_options options;
+    if (argc > 3) {
+        options.parser_threads = std::stoul(argv[3]);
+    }
+
+    const int vertex_count = std::stoi(argv[2]);
+    union_find sets(vertex_count);
+    ingest_stats stats;
+    try {
+        stats = ingest_edges_into(argv[1], sets, vertex_count, options);
+    } catch(const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << "edges: " << stats.edges << std::endl;
+    std::cout << "groups: " << sets.get_groups_count() << std::endl;
+    std::cout << "time: " << stats.seconds << " s" << std::endl;
+    std::cout << "throughput: " << stats.edges_per_second()/1e6 << " M edges/s, " << stats.bytes/stats.seconds/1e6 << " MB/s" << std::endl;
+    return 0;
+}
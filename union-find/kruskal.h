@@ -0,0 +1,199 @@
+#pragma once
+
+#include "union_find.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+template <typename weight_type>
+struct weighted_edge {
+    int from;
+    int to;
+    weight_type weight;
+};
+
+// Maps a weight to an unsigned key with the same ordering, so edges can be radix sorted
+template <typename weight_type>
+auto radix_key(const weight_type weight) noexcept {
+    static_assert(std::is_arithmetic_v<weight_type>, "radix sort requires arithmetic weights");
+    using key_type = std::conditional_t<sizeof(weight_type) <= 4, uint32_t, uint64_t>;
+    constexpr key_type sign_bit = key_type{1} << (8*sizeof(key_type)-1);
+
+    if constexpr (std::is_floating_point_v<weight_type>) {
+        using bits_type = std::conditional_t<sizeof(weight_type) == 4, uint32_t, uint64_t>;
+        const key_type bits = std::bit_cast<bits_type>(weight);
+        //Negative numbers have all bits flipped, positive only the sign bit
+        return (bits & sign_bit) ? key_type(~bits) : key_type(bits | sign_bit);
+    } else if constexpr (std::is_signed_v<weight_type>) {
+        return key_type(static_cast<std::make_unsigned_t<weight_type>>(weight)) ^ (key_type{1} << (8*sizeof(weight_type)-1));
+    } else {
+        return key_type(weight);
+    }
+}
+
+// Stable LSD radix sort by weight, 8 bits per pass. Every pass builds per-thread histograms
+// of contiguous chunks and then scatters the chunks in parallel. Passes in which all keys
+// share the same digit are skipped.
+template <typename weight_type>
+void parallel_radix_sort(std::vector<weighted_edge<weight_type>>& edges, unsigned thread_count = std::thread::hardware_concurrency()) {
+    using edge = weighted_edge<weight_type>;
+    using key_type = decltype(radix_key(weight_type{}));
+    constexpr size_t digit_count = 256;
+    constexpr size_t small_size = 1 << 12;
+
+    const size_t size = edges.size();
+    if (size <= small_size) {
+        std::stable_sort(std::begin(edges), std::end(edges), [](const edge& first, const edge& second){
+            return radix_key(first.weight) < radix_key(second.weight);
+        });
+        return;
+    }
+
+    thread_count = std::max(1u, std::min<unsigned>(thread_count, size/small_size));
+    const size_t chunk = (size+thread_count-1)/thread_count;
+    std::vector<edge> buffer(size);
+    std::vector<std::array<size_t, digit_count>> histograms(thread_count);
+
+    auto run_parallel = [thread_count](auto&& work) {
+        std::vector<std::thread> threads;
+        for(unsigned t = 1; t < thread_count; t++) {
+            threads.emplace_back(work, t);
+        }
+        work(0);
+        for(auto& thread : threads) {
+            thread.join();
+        }
+    };
+
+    edge* source = edges.data();
+    edge* target = buffer.data();
+    for(size_t shift = 0; shift < 8*sizeof(key_type); shift += 8) {
+        run_parallel([&](const unsigned t){
+            auto& histogram = histograms[t];
+            histogram.fill(0);
+            const size_t end = std::min(size, (t+1)*chunk);
+            for(size_t i = t*chunk; i < end; i++) {
+                histogram[(radix_key(source[i].weight) >> shift) & 0xFF]++;
+            }
+        });
+
+        //Exclusive prefix sum over (digit, thread), a pass with a single used digit is a no-op
+        size_t offset = 0;
+        size_t used_digits = 0;
+        for(size_t digit = 0; digit < digit_count; digit++) {
+            size_t digit_total = 0;
+            for(unsigned t = 0; t < thread_count; t++) {
+                const size_t count = histograms[t][digit];
+                histograms[t][digit] = offset;
+                offset += count;
+                digit_total += count;
+            }
+            used_digits += digit_total != 0;
+        }
+        if (used_digits == 1) {
+            continue;
+        }
+
+        run_parallel([&](const unsigned t){
+            auto& positions = histograms[t];
+            const size_t end = std::min(size, (t+1)*chunk);
+            for(size_t i = t*chunk; i < end; i++) {
+                target[positions[(radix_key(source[i].weight) >> shift) & 0xFF]++] = source[i];
+            }
+        });
+        std::swap(source, target);
+    }
+
+    if (source != edges.data()) {
+        std::copy(source, source+size, edges.data());
+    }
+}
+
+namespace kruskal_detail {
+    template <typename weight_type>
+    void scan(std::span<weighted_edge<weight_type>> edges, union_find& sets, std::vector<weighted_edge<weight_type>>& selected, const int target_groups) {
+        for(const auto& edge : edges) {
+            if (sets.get_groups_count() <= target_groups) {
+                return;
+            }
+            if (!sets.merge(edge.from, edge.to)) {
+                selected.push_back(edge);
+            }
+        }
+    }
+
+    template <typename weight_type>
+    void filter_kruskal(std::span<weighted_edge<weight_type>> edges, union_find& sets, std::vector<weighted_edge<weight_type>>& selected, const int target_groups, const size_t base_size, const unsigned thread_count) {
+        using edge = weighted_edge<weight_type>;
+        if (edges.empty() || sets.get_groups_count() <= target_groups) {
+            return;
+        }
+
+        if (edges.size() <= base_size) {
+            std::vector<edge> sorted(std::begin(edges), std::end(edges));
+            parallel_radix_sort(sorted, thread_count);
+            scan<weight_type>(sorted, sets, selected, target_groups);
+            return;
+        }
+
+        //Median of three as pivot, three-way partition keeps runs of equal weights from recursing forever
+        weight_type pivots[3] = {edges.front().weight, edges[edges.size()/2].weight, edges.back().weight};
+        std::sort(std::begin(pivots), std::end(pivots));
+        const weight_type pivot = pivots[1];
+
+        const auto light_end = std::partition(std::begin(edges), std::end(edges), [pivot](const edge& e){ return e.weight < pivot; });
+        const auto equal_end = std::partition(light_end, std::end(edges), [pivot](const edge& e){ return !(pivot < e.weight); });
+
+        filter_kruskal<weight_type>({std::begin(edges), light_end}, sets, selected, target_groups, base_size, thread_count);
+        scan<weight_type>({light_end, equal_end}, sets, selected, target_groups);
+        if (sets.get_groups_count() <= target_groups) {
+            return;
+        }
+
+        //Heavy edges inside an already connected component can never be selected
+        const auto heavy_end = std::remove_if(equal_end, std::end(edges), [&sets](const edge& e){ return sets.find(e.from) == sets.find(e.to); });
+        filter_kruskal<weight_type>({equal_end, heavy_end}, sets, selected, target_groups, base_size, thread_count);
+    }
+}
+
+// Classic Kruskal - sorts all edges and scans them. Stops once the forest has target_groups
+// components (1 = minimum spanning forest, k > 1 = single-linkage clustering into k clusters).
+template <typename weight_type>
+std::vector<weighted_edge<weight_type>> kruskal(const int vertex_count, std::vector<weighted_edge<weight_type>> edges, union_find& sets, const int target_groups = 1, const unsigned thread_count = std::thread::hardware_concurrency()) {
+    std::vector<weighted_edge<weight_type>> selected;
+    selected.reserve(std::max(0, vertex_count-target_groups));
+    parallel_radix_sort(edges, thread_count);
+    kruskal_detail::scan<weight_type>(edges, sets, selected, target_groups);
+    return selected;
+}
+
+// Filter-Kruskal - partitions around a pivot weight, solves the light half first and drops
+// heavy edges that became internal before they are ever sorted. Reorders the passed edges.
+template <typename weight_type>
+std::vector<weighted_edge<weight_type>> filter_kruskal(const int vertex_count, std::vector<weighted_edge<weight_type>>& edges, union_find& sets, const int target_groups = 1, const size_t base_size = 1 << 20, const unsigned thread_count = std::thread::hardware_concurrency()) {
+    std::vector<weighted_edge<weight_type>> selected;
+    selected.reserve(std::max(0, vertex_count-target_groups));
+    kruskal_detail::filter_kruskal<weight_type>(edges, sets, selected, target_groups, base_size, thread_count);
+    return selected;
+}
+
+template <typename weight_type>
+std::vector<weighted_edge<weight_type>> minimum_spanning_forest(const int vertex_count, std::vector<weighted_edge<weight_type>> edges) {
+    union_find sets(vertex_count);
+    return filter_kruskal(vertex_count, edges, sets);
+}
+
+// Single-linkage clustering into cluster_count clusters, returns the partition
+template <typename weight_type>
+union_find single_linkage_clustering(const int vertex_count, std::vector<weighted_edge<weight_type>> edges, const int cluster_count) {
+    union_find sets(vertex_count);
+    filter_kruskal(vertex_count, edges, sets, cluster_count);
+    return sets;
+}
@@ -0,0 +1,73 @@
+#include "kruskal.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+// Usage: kruskal_benchmark [edge_count = 10^8] [vertex_count = edge_count/10] [cluster_count = 100]
+
+using edge = weighted_edge<uint32_t>;
+
+std::vector<edge> random_graph(const int vertex_count, const size_t edge_count) {
+    std::vector<edge> edges(edge_count);
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<int> vertex(0, vertex_count-1);
+    for(auto& e : edges) {
+        e = {vertex(gen), vertex(gen), static_cast<uint32_t>(gen())};
+    }
+    return edges;
+}
+
+template <typename F>
+void measure(const std::string& name, const size_t edge_count, F&& f) {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t selected = f();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    std::cout << name << ": " << seconds << " s, " << edge_count/seconds/1e6 << " M edges/s, " << selected << " edges selected" << std::endl;
+}
+
+int main(int argc, char const *argv[]) {
+    const size_t edge_count = argc > 1 ? std::stoull(argv[1]) : 100'000'000;
+    const int vertex_count = argc > 2 ? std::stoi(argv[2]) : static_cast<int>(edge_count/10);
+    const int cluster_count = argc > 3 ? std::stoi(argv[3]) : 100;
+
+    std::cout << "vertices: " << vertex_count << ", edges: " << edge_count << ", threads: " << std::thread::hardware_concurrency() << std::endl;
+    const std::vector<edge> graph = random_graph(vertex_count, edge_count);
+
+    measure("std::sort + kruskal", edge_count, [&]{
+        std::vector<edge> edges = graph;
+        std::sort(std::begin(edges), std::end(edges), [](const edge& first, const edge& second){ return first.weight < second.weight; });
+        union_find sets(vertex_count);
+        size_t selected = 0;
+        for(const auto& e : edges) {
+            selected += !sets.merge(e.from, e.to);
+        }
+        return selected;
+    });
+
+    measure("radix sort + kruskal", edge_count, [&]{
+        union_find sets(vertex_count);
+        return kruskal(vertex_count, graph, sets).size();
+    });
+
+    measure("radix sort + kruskal (1 thread)", edge_count, [&]{
+        union_find sets(vertex_count);
+        return kruskal(vertex_count, graph, sets, 1, 1).size();
+    });
+
+    measure("filter-kruskal", edge_count, [&]{
+        std::vector<edge> edges = graph;
+        union_find sets(vertex_count);
+        return filter_kruskal(vertex_count, edges, sets).size();
+    });
+
+    measure("filter-kruskal clustering k=" + std::to_string(cluster_count), edge_count, [&]{
+        std::vector<edge> edges = graph;
+        union_find sets(vertex_count);
+        return filter_kruskal(vertex_count, edges, sets, cluster_count).size();
+    });
+
+    return 0;
+}
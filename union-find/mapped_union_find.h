@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// union_find whose arrays live in a memory-mapped file (POSIX). The state can exceed RAM,
+// survives restarts and reopening an existing file is O(1). The kernel writes dirty pages back
+// on its own, checkpoint() additionally flushes them to the disk and marks the file clean.
+// A file reopened without a final checkpoint gets its groups count and set sizes recounted from
+// the links in one pass over all elements.
+class mapped_union_find {
+    struct header {
+        uint64_t magic;
+        uint64_t count;
+        uint64_t groups_count;
+        uint64_t dirty;
+    };
+
+    static constexpr uint64_t file_magic = 0x3144465550414d55; // "UMAPUFD1"
+
+    header* state = nullptr;
+    int* roots = nullptr;
+    int* sizes = nullptr;
+    size_t mapped_size = 0;
+
+    static size_t file_size(const uint64_t count) noexcept {
+        return sizeof(header) + 2*count*sizeof(int);
+    }
+
+    static std::system_error error(const std::string& what) {
+        return std::system_error(errno, std::generic_category(), what);
+    }
+
+    void map(const int fd, const size_t size) {
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED) {
+            throw error("mmap");
+        }
+        mapped_size = size;
+        state = static_cast<header*>(address);
+        roots = reinterpret_cast<int*>(state+1);
+        sizes = roots + state->count;
+    }
+
+    void mark_dirty() noexcept {
+        if (!state->dirty) {
+            state->dirty = 1;
+        }
+    }
+
+public:
+    // Creates (or truncates) the file with max_count singleton sets
+    mapped_union_find(const std::string& path, const int max_count) {
+        const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw error("open " + path);
+        }
+        const size_t size = file_size(max_count);
+        if (ftruncate(fd, size) != 0) {
+            close(fd);
+            throw error("ftruncate " + path);
+        }
+        map(fd, size);
+        sizes = roots + max_count;
+
+        std::iota(roots, roots+max_count, 0);
+        std::fill(sizes, sizes+max_count, 1);
+        state->count = max_count;
+        state->groups_count = max_count;
+        state->dirty = 1;
+        state->magic = file_magic;
+        checkpoint();
+    }
+
+    // Reopens a file created by the constructor above
+    explicit mapped_union_find(const std::string& path) {
+        const int fd = open(path.c_str(), O_RDWR);
+        if (fd < 0) {
+            throw error("open " + path);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw error("fstat " + path);
+        }
+        if (static_cast<size_t>(info.st_size) < sizeof(header)) {
+            close(fd);
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "not a union-find file " + path);
+        }
+        map(fd, info.st_size);
+        if (state->magic != file_magic || file_size(state->count) != mapped_size) {
+            munmap(state, mapped_size);
+            state = nullptr;
+            throw std::system_error(std::make_error_code(std::errc::invalid_argument), "not a union-find file " + path);
+        }
+
+        if (state->dirty) {
+            //Only the links are trusted after a crash, merge may have linked two roots without
+            //updating the size or the counter yet
+            std::fill(sizes, sizes+state->count, 0);
+            state->groups_count = 0;
+            for(uint64_t i = 0; i < state->count; i++) {
+                const int root_idx = find(static_cast<int>(i));
+                sizes[root_idx]++;
+                state->groups_count += root_idx == static_cast<int>(i);
+            }
+        }
+    }
+
+    mapped_union_find(const mapped_union_find&) = delete;
+    mapped_union_find& operator=(const mapped_union_find&) = delete;
+
+    mapped_union_find(mapped_union_find&& other) noexcept : state(std::exchange(other.state, nullptr)), roots(other.roots), sizes(other.sizes), mapped_size(other.mapped_size) {
+    }
+
+    mapped_union_find& operator=(mapped_union_find&& other) noexcept {
+        std::swap(state, other.state);
+        std::swap(roots, other.roots);
+        std::swap(sizes, other.sizes);
+        std::swap(mapped_size, other.mapped_size);
+        return *this;
+    }
+
+    ~mapped_union_find() {
+        if (state) {
+            munmap(state, mapped_size);
+        }
+    }
+
+    // Flushes the state to the disk, after it returns the file is a consistent snapshot
+    void checkpoint() {
+        if (msync(state, mapped_size, MS_SYNC) != 0) {
+            throw error("msync");
+        }
+        state->dirty = 0;
+        if (msync(state, sizeof(header), MS_SYNC) != 0) {
+            throw error("msync");
+        }
+    }
+
+    int find(int idx) noexcept {
+        //Find root index
+        int root_idx = idx;
+        while(root_idx != roots[root_idx]) {
+            root_idx = roots[root_idx];
+        }
+
+        //Reconnect all elements to root
+        if (idx != root_idx) {
+            mark_dirty();
+        }
+        while (idx != root_idx) {
+            const int next_idx = roots[idx];
+            roots[idx] = root_idx;
+            idx = next_idx;
+        }
+
+        return root_idx;
+    }
+
+    bool merge(const int first, const int second) noexcept {
+        int first_idx = find(first);
+        int second_idx = find(second);
+
+        if (first_idx == second_idx) {
+            return true;
+        }
+
+        mark_dirty();
+
+        if(sizes[first_idx] > sizes[second_idx]){
+            std::swap(first_idx, second_idx);
+        }
+
+        roots[first_idx] = second_idx;
+        sizes[second_idx] += sizes[first_idx];
+        state->groups_count--;
+
+        return false;
+    }
+
+    int get_group_size(const int idx) noexcept {
+        return sizes[find(idx)];
+    }
+
+    int size() const noexcept {
+        return static_cast<int>(state->count);
+    }
+
+    int get_groups_count() const noexcept {
+        return static_cast<int>(state->groups_count);
+    }
+};
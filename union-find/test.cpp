@@ -0,0 +1,976 @@
+#include "union_find.h"
+#include "dynamic_connectivity.h"
+#include "distributed_union_find.h"
+#include "edge_ingest.h"
+#include "dynamic_union_find.h"
+#include "weighted_union_find.h"
+#include "aggregate_union_find.h"
+#include "mapped_union_find.h"
+#include "kruskal.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+// Quadratic reference implementation - every element stores the label of its group
+class naive_union_find {
+    std::vector<int> labels;
+    int groups_count;
+
+public:
+    naive_union_find(const int max_count) : labels(max_count), groups_count(max_count) {
+        std::iota(std::begin(labels), std::end(labels), 0);
+    }
+
+    bool same_set(const int first, const int second) const {
+        return labels[first] == labels[second];
+    }
+
+    bool merge(const int first, const int second) {
+        const int old_label = labels[first];
+        const int new_label = labels[second];
+        if (old_label == new_label) {
+            return true;
+        }
+        std::replace(std::begin(labels), std::end(labels), old_label, new_label);
+        groups_count--;
+        return false;
+    }
+
+    int get_groups_count() const {
+        return groups_count;
+    }
+};
+
+class UnionFindRandomized : public testing::TestWithParam<std::tuple<int, int>> {};
+
+TEST_P(UnionFindRandomized, MatchesNaiveReference) {
+    const auto [element_count, seed] = GetParam();
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> element(0, element_count-1);
+
+    union_find sets(element_count);
+    naive_union_find reference(element_count);
+
+    for(int step = 0; step < 4*element_count; step++) {
+        const int first = element(gen);
+        const int second = element(gen);
+        if (gen() % 2) {
+            ASSERT_EQ(sets.merge(first, second), reference.merge(first, second));
+        } else {
+            ASSERT_EQ(sets.find(first) == sets.find(second), reference.same_set(first, second));
+        }
+        ASSERT_EQ(sets.get_groups_count(), reference.get_groups_count());
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Sizes, UnionFindRandomized, testing::Combine(testing::Values(1, 2, 10, 100, 1000), testing::Values(1, 2, 3)));
+
+TEST(UnionFind, FindReturnsRepresentative) {
+    union_find sets(5);
+    for(int i = 0; i < 5; i++) {
+        EXPECT_EQ(sets.find(i), i);
+    }
+    sets.merge(0, 1);
+    sets.merge(1, 2);
+    EXPECT_EQ(sets.find(0), sets.find(2));
+    EXPECT_NE(sets.find(0), sets.find(3));
+    EXPECT_EQ(sets.get_groups_count(), 3);
+}
+
+TEST(UnionFind, LongChainMergeKeepsFindShallow) {
+    constexpr int element_count = 1'000'000;
+    union_find sets(element_count);
+    for(int i = 1; i < element_count; i++) {
+        ASSERT_FALSE(sets.merge(i-1, i));
+    }
+    EXPECT_EQ(sets.get_groups_count(), 1);
+    EXPECT_EQ(sets.find(0), sets.find(element_count-1));
+}
+
+TEST(UnionFind, BatchedCallsMatchSingleCalls) {
+    constexpr int element_count = 10'000;
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> element(0, element_count-1);
+    std::vector<std::pair<int, int>> pairs(element_count/2);
+    for(auto& [first, second] : pairs) {
+        first = element(gen);
+        second = element(gen);
+    }
+
+    union_find single(element_count);
+    union_find batched(element_count);
+    int merged = 0;
+    for(const auto& [first, second] : pairs) {
+        merged += !single.merge(first, second);
+    }
+    EXPECT_EQ(batched.merge_many(pairs), merged);
+    EXPECT_EQ(batched.get_groups_count(), single.get_groups_count());
+
+    std::vector<int> indices(element_count);
+    std::iota(std::begin(indices), std::end(indices), 0);
+    std::vector<int> roots(element_count);
+    batched.find_many(indices, roots);
+    for(int i = 0; i < element_count; i++) {
+        ASSERT_EQ(roots[i], batched.find(i));
+    }
+
+    std::reverse(std::begin(pairs), std::end(pairs));
+    auto same = std::make_unique<bool[]>(pairs.size());
+    batched.same_set_many(pairs, {same.get(), pairs.size()});
+    for(size_t i = 0; i < pairs.size(); i++) {
+        ASSERT_EQ(same[i], single.find(pairs[i].first) == single.find(pairs[i].second));
+    }
+}
+
+TEST(UnionFind, CompactProducesDenseLabelsAndMembers) {
+    constexpr int element_count = 200'000;
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> element(0, element_count-1);
+    union_find sets(element_count);
+    for(int i = 0; i < element_count; i++) {
+        sets.merge(element(gen), element(gen));
+    }
+
+    const component_index index = sets.compact_with_members(4);
+    ASSERT_EQ(static_cast<int>(index.offsets.size()), sets.get_groups_count()+1);
+    EXPECT_EQ(index.offsets.back(), element_count);
+
+    int next_label = 0;
+    for(int i = 0; i < element_count; i++) {
+        ASSERT_LE(index.labels[i], next_label);
+        next_label = std::max(next_label, index.labels[i]+1);
+        ASSERT_EQ(index.labels[i], index.labels[sets.find(i)]);
+    }
+    EXPECT_EQ(next_label, sets.get_groups_count());
+
+    for(int component = 0; component < sets.get_groups_count(); component++) {
+        const int begin = index.offsets[component];
+        const int end = index.offsets[component+1];
+        ASSERT_LT(begin, end);
+        for(int position = begin; position < end; position++) {
+            ASSERT_EQ(index.labels[index.members[position]], component);
+            if (position > begin) {
+                ASSERT_LT(index.members[position-1], index.members[position]);
+            }
+        }
+    }
+}
+
+TEST(UnionFind, ParallelExclusiveScan) {
+    std::vector<int> values(1'000'003);
+    std::mt19937 gen(5);
+    for(int& value : values) {
+        value = gen() % 10;
+    }
+    std::vector<int> expected(values.size());
+    std::exclusive_scan(std::begin(values), std::end(values), std::begin(expected), 0);
+    parallel_exclusive_scan(values, 7);
+    EXPECT_EQ(values, expected);
+}
+
+TEST(DynamicConnectivity, MatchesRebuiltUnionFind) {
+    for(int seed = 0; seed < 10; seed++) {
+        std::mt19937 gen(seed);
+        const int element_count = 1 + gen() % 50;
+        dynamic_connectivity graph(element_count);
+        std::set<std::pair<int, int>> edges;
+
+        auto rebuild = [&]{
+            union_find sets(element_count);
+            for(const auto& [first, second] : edges) {
+                sets.merge(first, second);
+            }
+            return sets;
+        };
+
+        for(int step = 0; step < 2000; step++) {
+            int first = gen() % element_count;
+            int second = gen() % element_count;
+            if (first > second) {
+                std::swap(first, second);
+            }
+
+            if (gen() % 2 || edges.empty()) {
+                union_find reference = rebuild();
+                ASSERT_EQ(graph.merge(first, second), reference.find(first) == reference.find(second));
+                if (first != second) {
+                    edges.emplace(first, second);
+                }
+            } else {
+                auto it = std::next(std::begin(edges), gen() % edges.size());
+                std::tie(first, second) = *it;
+                edges.erase(it);
+                union_find reference = rebuild();
+                ASSERT_EQ(graph.split(first, second), reference.find(first) != reference.find(second));
+            }
+
+            union_find reference = rebuild();
+            ASSERT_EQ(graph.get_groups_count(), reference.get_groups_count());
+            const int query_first = gen() % element_count;
+            const int query_second = gen() % element_count;
+            ASSERT_EQ(graph.same_set(query_first, query_second), reference.find(query_first) == reference.find(query_second));
+            ASSERT_EQ(graph.find(query_first) == graph.find(query_second), reference.find(query_first) == reference.find(query_second));
+        }
+    }
+}
+
+// Labels describe the same partition as the reference: each label maps to exactly one reference root and back
+void expect_same_partition(const std::vector<int>& labels, union_find& reference) {
+    const int element_count = static_cast<int>(labels.size());
+    std::vector<int> root_of_label(element_count, -1);
+    std::vector<int> label_of_root(element_count, -1);
+    for(int i = 0; i < element_count; i++) {
+        ASSERT_EQ(labels[labels[i]], labels[i]);
+        const int root = reference.find(i);
+        if (root_of_label[labels[i]] == -1 && label_of_root[root] == -1) {
+            root_of_label[labels[i]] = root;
+            label_of_root[root] = labels[i];
+        }
+        ASSERT_EQ(root_of_label[labels[i]], root) << i;
+        ASSERT_EQ(label_of_root[root], labels[i]) << i;
+    }
+}
+
+class DistributedPartition : public testing::TestWithParam<int> {};
+
+TEST_P(DistributedPartition, MatchesSingleProcess) {
+    const int worker_count = GetParam();
+    constexpr int element_count = 50'000;
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<int> element(0, element_count-1);
+    std::vector<std::pair<int, int>> edges(element_count);
+    for(auto& [first, second] : edges) {
+        first = element(gen);
+        second = element(gen);
+    }
+
+    union_find reference(element_count);
+    for(const auto& [first, second] : edges) {
+        reference.merge(first, second);
+    }
+
+    const std::vector<int> labels = distributed_partition(element_count, worker_count, [&edges, worker_count](const int worker, union_find& local){
+        for(size_t i = worker; i < edges.size(); i += worker_count) {
+            local.merge(edges[i].first, edges[i].second);
+        }
+    });
+    expect_same_partition(labels, reference);
+}
+
+
+TEST_P(DistributedPartition, SparseShardsMatchSingleProcess) {
+    //Few edges over many vertices, every worker only touches a small part of the vertices
+    const int worker_count = GetParam();
+    constexpr int element_count = 1'000'000;
+    std::mt19937 gen(14);
+    std::uniform_int_distribution<int> element(0, element_count-1);
+    std::vector<std::pair<int, int>> edges(2000);
+    for(auto& [first, second] : edges) {
+        first = element(gen);
+        second = gen() % 4 ? element(gen) : edges[gen() % edges.size()].first;
+    }
+
+    union_find reference(element_count);
+    for(const auto& [first, second] : edges) {
+        reference.merge(first, second);
+    }
+
+    const std::vector<int> labels = distributed_partition(element_count, worker_count, [&edges, worker_count](const int worker, union_find& local){
+        for(size_t i = worker; i < edges.size(); i += worker_count) {
+            local.merge(edges[i].first, edges[i].second);
+        }
+    });
+    expect_same_partition(labels, reference);
+}
+INSTANTIATE_TEST_SUITE_P(Workers, DistributedPartition, testing::Values(1, 2, 3, 4, 7));
+
+TEST(DistributedPartition, ReportsFailedWorker) {
+    EXPECT_THROW(distributed_partition(100, 4, [](const int worker, union_find&){
+        if (worker == 2) {
+            throw std::runtime_error("shard not found");
+        }
+    }), std::runtime_error);
+}
+
+// Path in the temporary directory, the file is removed at the end of the test
+class temporary_file {
+    std::filesystem::path path_;
+
+public:
+    explicit temporary_file(const std::string& name, const std::string& contents = "") {
+        path_ = std::filesystem::temp_directory_path() / (name + "." + std::to_string(getpid()));
+        std::ofstream(path_, std::ios::binary) << contents;
+    }
+
+    ~temporary_file() {
+        std::filesystem::remove(path_);
+    }
+
+    std::string path() const {
+        return path_.string();
+    }
+};
+
+TEST(EdgeIngest, ParseNumber) {
+    for(const std::string text : {"0 ", "7\n", "12345678 ", "123456789012\n", "18446744073709551615 ", "4294967296"}) {
+        const char* position = text.data();
+        const uint64_t value = ingest_detail::parse_number(position, text.data()+text.size());
+        EXPECT_EQ(value, std::stoull(text)) << text;
+        EXPECT_EQ(position, text.data()+std::min(text.size(), text.find_first_not_of("0123456789"))) << text;
+    }
+    const std::string too_long = "123456789012345678901234 1";
+    const char* position = too_long.data();
+    EXPECT_EQ(ingest_detail::parse_number(position, too_long.data()+too_long.size()), std::numeric_limits<uint64_t>::max());
+    EXPECT_EQ(*position, ' ');
+}
+
+TEST(EdgeIngest, ParseChunk) {
+    const std::string text = "# comment 1 2\r\n% other comment\n1 2\r\n30 400\textra 5\n\n123456789 987654321\r\n7 8";
+    std::vector<edge_pair> edges;
+    ingest_detail::parse_chunk(text.data(), text.data()+text.size(), text.data()+text.size(), edges);
+    const std::vector<edge_pair> expected{{1, 2}, {30, 400}, {123456789, 987654321}, {7, 8}};
+    EXPECT_EQ(edges, expected);
+
+    //Every split just after a newline gives the same edges
+    for(size_t split = 0; split < text.size(); split++) {
+        if (split != 0 && text[split-1] != '\n') {
+            continue;
+        }
+        std::vector<edge_pair> split_edges;
+        ingest_detail::parse_chunk(text.data(), text.data()+split, text.data()+text.size(), split_edges);
+        ingest_detail::parse_chunk(text.data()+split, text.data()+text.size(), text.data()+text.size(), split_edges);
+        EXPECT_EQ(split_edges, expected) << split;
+    }
+
+    const std::string huge = "1 4294967296\n";
+    EXPECT_THROW(ingest_detail::parse_chunk(huge.data(), huge.data()+huge.size(), huge.data()+huge.size(), edges), std::out_of_range);
+}
+
+TEST(EdgeIngest, SmallChunksMatchSingleChunk) {
+    std::mt19937 gen(17);
+    std::string text;
+    std::vector<edge_pair> expected;
+    for(int i = 0; i < 5000; i++) {
+        const uint32_t first = gen() % 100'000'000;
+        const uint32_t second = gen() % 1000;
+        if (i % 97 == 0) {
+            text += "# comment\n";
+        }
+        text += std::to_string(first) + (i % 2 ? "\t" : " ") + std::to_string(second) + (i % 3 ? "\n" : "\r\n");
+        expected.emplace_back(first, second);
+    }
+    text.pop_back();
+    const temporary_file file("edge_ingest_chunks", text);
+
+    ingest_options options;
+    options.parser_threads = 3;
+    options.chunk_size = 61;
+    options.queue_capacity = 2;
+    std::vector<edge_pair> edges;
+    const ingest_stats stats = ingest_edges(file.path(), [&edges](const std::span<const edge_pair> batch){
+        edges.insert(std::end(edges), std::begin(batch), std::end(batch));
+    }, options);
+    EXPECT_EQ(stats.edges, expected.size());
+    std::sort(std::begin(edges), std::end(edges));
+    std::sort(std::begin(expected), std::end(expected));
+    EXPECT_EQ(edges, expected);
+}
+
+TEST(EdgeIngest, RejectsOutOfRangeIds) {
+    ingest_options options;
+    options.parser_threads = 2;
+    options.chunk_size = 16;
+    options.queue_capacity = 1;
+
+    std::string text;
+    for(int i = 0; i < 1000; i++) {
+        text += std::to_string(i % 100) + " " + std::to_string((i+1) % 100) + "\n";
+    }
+    const temporary_file in_range("edge_ingest_in_range", text);
+    union_find sets(100);
+    EXPECT_EQ(ingest_edges_into(in_range.path(), sets, 100, options).edges, 1000);
+    EXPECT_EQ(sets.get_groups_count(), 1);
+
+    const temporary_file too_large("edge_ingest_too_large", text + "5 100\n" + text);
+    union_find other_sets(100);
+    EXPECT_THROW(ingest_edges_into(too_large.path(), other_sets, 100, options), std::out_of_range);
+
+    const temporary_file too_wide("edge_ingest_too_wide", text + "3 8589934592\n" + text);
+    EXPECT_THROW(ingest_edges_into(too_wide.path(), other_sets, 100, options), std::out_of_range);
+}
+
+template <typename index_type>
+void check_dynamic_against_naive(const int element_count, const int reserved, const unsigned seed) {
+    std::mt19937 gen(seed);
+    dynamic_union_find<index_type> sets(static_cast<index_type>(reserved));
+    naive_union_find reference(element_count);
+    int added = reserved;
+
+    for(int step = 0; step < 6*element_count; step++) {
+        //Elements are added while the sets are merged, far past the reserved capacity
+        if (added == 0 || (added < element_count && gen() % 2)) {
+            ASSERT_EQ(sets.make_set(), static_cast<index_type>(added));
+            added++;
+            ASSERT_EQ(sets.size(), static_cast<index_type>(added));
+            continue;
+        }
+        const int first = gen() % added;
+        const int second = gen() % added;
+        if (gen() % 2) {
+            ASSERT_EQ(sets.merge(first, second), reference.merge(first, second));
+        } else {
+            ASSERT_EQ(sets.find(first) == sets.find(second), reference.same_set(first, second));
+        }
+        ASSERT_EQ(sets.get_groups_count(), static_cast<index_type>(reference.get_groups_count()-(element_count-added)));
+    }
+
+    std::vector<int> group_sizes(element_count, 0);
+    for(int i = 0; i < added; i++) {
+        group_sizes[sets.find(i)]++;
+    }
+    for(int i = 0; i < added; i++) {
+        ASSERT_EQ(sets.get_group_size(i), static_cast<index_type>(group_sizes[sets.find(i)]));
+    }
+}
+
+TEST(DynamicUnionFind, GrowsPastReserveLikeNaiveReference) {
+    for(const unsigned seed : {1u, 2u, 3u}) {
+        check_dynamic_against_naive<uint32_t>(1000, 0, seed);
+        check_dynamic_against_naive<uint32_t>(1000, 10, seed);
+    }
+}
+
+TEST(DynamicUnionFind, WideIndexType) {
+    for(const unsigned seed : {1u, 2u}) {
+        check_dynamic_against_naive<uint64_t>(1000, 1, seed);
+    }
+    check_dynamic_against_naive<uint16_t>(500, 3, 4);
+}
+
+TEST(HashedUnionFind, MatchesNaiveReferenceWhileGrowing) {
+    constexpr int key_count = 3000;
+    std::mt19937_64 gen(5);
+    std::vector<uint64_t> keys(key_count);
+    for(auto& key : keys) {
+        key = gen();
+    }
+
+    //Default construction starts with the smallest table, so inserts rehash it repeatedly
+    hashed_union_find<uint64_t> sets;
+    naive_union_find reference(key_count);
+    std::unordered_map<uint64_t, uint32_t> dense;
+    std::vector<int> key_of_dense;
+    auto expect_inserted = [&](const int key_idx) {
+        if (dense.emplace(keys[key_idx], static_cast<uint32_t>(key_of_dense.size())).second) {
+            key_of_dense.push_back(key_idx);
+        }
+        EXPECT_EQ(sets.index_of(keys[key_idx]), dense.at(keys[key_idx]));
+        EXPECT_EQ(sets.key_of(dense.at(keys[key_idx])), keys[key_idx]);
+    };
+
+    for(int step = 0; step < 6*key_count; step++) {
+        const int first = gen() % key_count;
+        const int second = gen() % key_count;
+        switch(gen() % 4) {
+        case 0:
+            sets.insert(keys[first]);
+            expect_inserted(first);
+            break;
+        case 1:
+            ASSERT_EQ(sets.merge(keys[first], keys[second]), reference.merge(first, second));
+            expect_inserted(first);
+            expect_inserted(second);
+            break;
+        case 2:
+            //Unknown keys are only equal to themselves and are not inserted by same_set
+            ASSERT_EQ(sets.same_set(keys[first], keys[second]), reference.same_set(first, second));
+            break;
+        default:
+            ASSERT_EQ(sets.contains(keys[first]), dense.count(keys[first]) == 1);
+            if (dense.count(keys[first]) && dense.count(keys[second])) {
+                ASSERT_EQ(sets.find(keys[first]) == sets.find(keys[second]), reference.same_set(first, second));
+            }
+            break;
+        }
+        ASSERT_EQ(sets.size(), static_cast<uint32_t>(key_of_dense.size()));
+        ASSERT_EQ(sets.get_groups_count(), static_cast<uint32_t>(reference.get_groups_count()-(key_count-static_cast<int>(key_of_dense.size()))));
+    }
+
+    //The representative is a member of the group
+    for(const int key_idx : key_of_dense) {
+        const uint64_t representative = sets.find(keys[key_idx]);
+        ASSERT_TRUE(reference.same_set(key_idx, key_of_dense[dense.at(representative)]));
+    }
+}
+
+TEST(HashedUnionFind, StridedKeys) {
+    //Identity hash with keys sharing all low bits, would probe one long run without mixing
+    constexpr int key_count = 200'000;
+    hashed_union_find<uint64_t> sets;
+    for(int i = 1; i < key_count; i++) {
+        sets.merge(uint64_t(i-1) << 20, uint64_t(i) << 20);
+    }
+    EXPECT_EQ(sets.size(), static_cast<uint32_t>(key_count));
+    EXPECT_EQ(sets.get_groups_count(), 1u);
+    EXPECT_TRUE(sets.contains(uint64_t(key_count-1) << 20));
+    EXPECT_FALSE(sets.contains(uint64_t(key_count) << 20));
+}
+
+TEST(DynamicUnionFind, ThrowsWhenIndexTypeIsExhausted) {
+    dynamic_union_find<uint16_t> sets;
+    for(int i = 0; i < 65535; i++) {
+        ASSERT_EQ(sets.make_set(), i);
+    }
+    EXPECT_THROW(sets.make_set(), std::length_error);
+    EXPECT_EQ(sets.size(), 65535);
+
+    hashed_union_find<int, uint16_t> hashed;
+    for(int i = 0; i < 65535; i++) {
+        hashed.insert(i);
+    }
+    EXPECT_THROW(hashed.insert(-1), std::length_error);
+    EXPECT_FALSE(hashed.contains(-1));
+    EXPECT_EQ(hashed.size(), 65535);
+    EXPECT_TRUE(hashed.merge(0, 0));
+}
+
+TEST(HashedUnionFind, GrowsPastExpectedCount) {
+    constexpr int key_count = 1000;
+    hashed_union_find<std::string> sets(4);
+    for(int i = 1; i < key_count; i++) {
+        ASSERT_FALSE(sets.merge("key" + std::to_string(i-1), "key" + std::to_string(i)));
+    }
+    EXPECT_EQ(sets.size(), static_cast<uint32_t>(key_count));
+    EXPECT_EQ(sets.get_groups_count(), 1u);
+    EXPECT_TRUE(sets.same_set("key0", "key" + std::to_string(key_count-1)));
+    EXPECT_FALSE(sets.same_set("key0", "missing"));
+    EXPECT_TRUE(sets.same_set("missing", "missing"));
+    EXPECT_FALSE(sets.contains("missing"));
+}
+
+// Every element gets a hidden potential, merges state the true differences (or a wrong one)
+template <typename Group>
+void check_weighted_against_hidden_potentials(const int element_count, const unsigned seed, const typename Group::value_type wrong_delta, auto&& random_potential) {
+    using value_type = typename Group::value_type;
+    std::mt19937 gen(seed);
+    std::vector<value_type> potentials(element_count);
+    for(auto& potential : potentials) {
+        potential = random_potential(gen);
+    }
+    auto hidden_diff = [&potentials](const int first, const int second) {
+        return Group::combine(potentials[second], Group::inverse(potentials[first]));
+    };
+
+    weighted_union_find<Group> sets(element_count);
+    naive_union_find reference(element_count);
+    for(int step = 0; step < 6*element_count; step++) {
+        const int first = gen() % element_count;
+        const int second = gen() % element_count;
+        switch(gen() % 3) {
+        case 0:
+            ASSERT_EQ(sets.add_constraint(first, second, hidden_diff(first, second)), reference.merge(first, second) ? constraint_result::redundant : constraint_result::merged);
+            break;
+        case 1: {
+            //A contradicting constraint is rejected between connected elements only
+            const bool connected = reference.same_set(first, second);
+            ASSERT_EQ(sets.add_constraint(first, second, Group::combine(hidden_diff(first, second), wrong_delta)), connected ? constraint_result::contradiction : constraint_result::merged);
+            if (!connected) {
+                //Keep the hidden potentials consistent with the accepted constraint
+                const value_type shift = wrong_delta;
+                for(int i = 0; i < element_count; i++) {
+                    if (reference.same_set(i, second)) {
+                        potentials[i] = Group::combine(potentials[i], shift);
+                    }
+                }
+                reference.merge(first, second);
+            }
+            break;
+        }
+        default: {
+            const std::optional<value_type> diff = sets.diff(first, second);
+            ASSERT_EQ(diff.has_value(), reference.same_set(first, second));
+            if (diff) {
+                ASSERT_EQ(*diff, hidden_diff(first, second));
+            }
+            break;
+        }
+        }
+        ASSERT_EQ(sets.get_groups_count(), reference.get_groups_count());
+    }
+
+    //After full path compression every potential is relative to the root
+    for(int i = 0; i < element_count; i++) {
+        const int root = sets.find(i);
+        ASSERT_EQ(sets.potential(i), hidden_diff(root, i));
+        ASSERT_EQ(sets.potential(root), Group::identity());
+    }
+    for(int step = 0; step < element_count; step++) {
+        const int first = gen() % element_count;
+        const int second = gen() % element_count;
+        if (reference.same_set(first, second)) {
+            ASSERT_EQ(sets.diff(first, second), hidden_diff(first, second));
+            ASSERT_EQ(sets.add_constraint(first, second, hidden_diff(first, second)), constraint_result::redundant);
+            ASSERT_EQ(sets.add_constraint(first, second, Group::combine(hidden_diff(first, second), wrong_delta)), constraint_result::contradiction);
+        }
+    }
+}
+
+TEST(WeightedUnionFind, AdditiveMatchesHiddenPotentials) {
+    for(const int element_count : {2, 10, 300}) {
+        for(const unsigned seed : {1u, 2u, 3u}) {
+            check_weighted_against_hidden_potentials<additive_group<long long>>(element_count, seed, 7, [](std::mt19937& gen){
+                return std::uniform_int_distribution<long long>(-1'000'000, 1'000'000)(gen);
+            });
+        }
+    }
+}
+
+TEST(WeightedUnionFind, XorParityMatchesHiddenBits) {
+    for(const int element_count : {2, 10, 300}) {
+        for(const unsigned seed : {1u, 2u, 3u}) {
+            check_weighted_against_hidden_potentials<xor_group<int>>(element_count, seed, 1, [](std::mt19937& gen){
+                return static_cast<int>(gen() % 2);
+            });
+        }
+    }
+}
+
+TEST(WeightedUnionFind, BipartiteCheck) {
+    //Odd cycle closes with a contradicting parity, even cycle does not
+    weighted_union_find<xor_group<int>> sets(6);
+    EXPECT_EQ(sets.add_constraint(0, 1, 1), constraint_result::merged);
+    EXPECT_EQ(sets.add_constraint(1, 2, 1), constraint_result::merged);
+    EXPECT_EQ(sets.add_constraint(2, 0, 1), constraint_result::contradiction);
+    EXPECT_EQ(sets.add_constraint(3, 4, 1), constraint_result::merged);
+    EXPECT_EQ(sets.add_constraint(4, 5, 1), constraint_result::merged);
+    EXPECT_EQ(sets.add_constraint(5, 2, 1), constraint_result::merged);
+    EXPECT_EQ(sets.add_constraint(3, 0, 1), constraint_result::redundant);
+    EXPECT_EQ(sets.diff(0, 5), 1);
+    EXPECT_EQ(sets.get_groups_count(), 1);
+    EXPECT_EQ(weighted_union_find<xor_group<int>>(2).diff(0, 1), std::nullopt);
+}
+
+// Aggregates are recomputed from the naive reference labels after every step
+template <typename Monoid, bool track_members>
+void check_aggregates_against_naive(const int element_count, const unsigned seed) {
+    using value_type = typename Monoid::value_type;
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> random_value(-1000, 1000);
+    std::vector<value_type> values(element_count);
+    for(auto& value : values) {
+        value = random_value(gen);
+    }
+
+    aggregate_union_find<Monoid, track_members> sets(values);
+    naive_union_find reference(element_count);
+    for(int step = 0; step < 4*element_count; step++) {
+        const int first = gen() % element_count;
+        const int second = gen() % element_count;
+        if (gen() % 4 == 0) {
+            //Extra values are folded into the component, attach them to an arbitrary member
+            const value_type value = random_value(gen);
+            sets.add_value(first, value);
+            values[first] = Monoid::combine(values[first], value);
+        } else {
+            ASSERT_EQ(sets.merge(first, second), reference.merge(first, second));
+        }
+        ASSERT_EQ(sets.get_groups_count(), reference.get_groups_count());
+
+        value_type expected = Monoid::identity();
+        int expected_size = 0;
+        std::vector<int> expected_members;
+        for(int i = 0; i < element_count; i++) {
+            if (reference.same_set(i, first)) {
+                expected = Monoid::combine(expected, values[i]);
+                expected_size++;
+                expected_members.push_back(i);
+            }
+        }
+        ASSERT_EQ(sets.aggregate(sets.find(first)), expected);
+        ASSERT_EQ(sets.get_group_size(first), expected_size);
+        if constexpr (track_members) {
+            std::vector<int> members = sets.members(first);
+            ASSERT_EQ(members.front(), first);
+            std::sort(std::begin(members), std::end(members));
+            ASSERT_EQ(members, expected_members);
+
+            int visited = 0;
+            sets.for_each_member(second, [&](const int member){
+                ASSERT_TRUE(reference.same_set(member, second));
+                visited++;
+            });
+            ASSERT_EQ(visited, sets.get_group_size(second));
+        }
+    }
+}
+
+TEST(AggregateUnionFind, SumMatchesNaiveReference) {
+    for(const int element_count : {1, 10, 200}) {
+        check_aggregates_against_naive<sum_monoid<long long>, false>(element_count, 1);
+        check_aggregates_against_naive<sum_monoid<long long>, true>(element_count, 2);
+    }
+}
+
+TEST(AggregateUnionFind, MinMaxMatchNaiveReference) {
+    for(const int element_count : {1, 10, 200}) {
+        check_aggregates_against_naive<min_monoid<int>, true>(element_count, 3);
+        check_aggregates_against_naive<max_monoid<int>, false>(element_count, 4);
+        check_aggregates_against_naive<max_monoid<double>, true>(element_count, 5);
+    }
+}
+
+TEST(AggregateUnionFind, IdentityInitializedCountsAddedValues) {
+    aggregate_union_find<sum_monoid<int>, true> sets(4);
+    sets.add_value(0, 5);
+    sets.add_value(3, 7);
+    EXPECT_TRUE(sets.members(2) == std::vector<int>{2});
+    EXPECT_FALSE(sets.merge(0, 3));
+    EXPECT_TRUE(sets.merge(3, 0));
+    EXPECT_EQ(sets.aggregate(sets.find(0)), 12);
+    EXPECT_EQ(sets.aggregate(sets.find(1)), 0);
+    std::vector<int> members = sets.members(3);
+    std::sort(std::begin(members), std::end(members));
+    EXPECT_EQ(members, (std::vector<int>{0, 3}));
+}
+
+// Overwrites bytes of a closed file in place
+void patch_file(const std::string& path, const std::streamoff offset, const std::string& bytes) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.write(bytes.data(), bytes.size());
+}
+
+void merge_randomly(mapped_union_find& sets, naive_union_find& reference, const int element_count, std::mt19937& gen) {
+    for(int step = 0; step < element_count; step++) {
+        const int first = gen() % element_count;
+        const int second = gen() % element_count;
+        ASSERT_EQ(sets.merge(first, second), reference.merge(first, second));
+    }
+}
+
+void expect_same_partition(mapped_union_find& sets, const naive_union_find& reference, const int element_count) {
+    ASSERT_EQ(sets.size(), element_count);
+    ASSERT_EQ(sets.get_groups_count(), reference.get_groups_count());
+    for(int i = 0; i < element_count; i++) {
+        for(int j = i+1; j < element_count; j += 7) {
+            ASSERT_EQ(sets.find(i) == sets.find(j), reference.same_set(i, j));
+        }
+    }
+}
+
+TEST(MappedUnionFind, ReopensCheckpointedFile) {
+    constexpr int element_count = 2000;
+    const temporary_file file("mapped_union_find_checkpoint");
+    std::mt19937 gen(3);
+    naive_union_find reference(element_count);
+    {
+        mapped_union_find sets(file.path(), element_count);
+        merge_randomly(sets, reference, element_count, gen);
+        sets.checkpoint();
+    }
+    EXPECT_EQ(std::filesystem::file_size(file.path()), 32 + 2*element_count*sizeof(int));
+
+    mapped_union_find reopened(file.path());
+    expect_same_partition(reopened, reference, element_count);
+
+    //Merges continue on the reopened file and survive another reopen
+    merge_randomly(reopened, reference, element_count, gen);
+    reopened.checkpoint();
+    mapped_union_find moved = std::move(reopened);
+    expect_same_partition(moved, reference, element_count);
+    mapped_union_find again(file.path());
+    expect_same_partition(again, reference, element_count);
+}
+
+TEST(MappedUnionFind, RecountsGroupsAndSizesOfDirtyFile) {
+    constexpr int element_count = 2000;
+    const temporary_file file("mapped_union_find_dirty");
+    std::mt19937 gen(4);
+    naive_union_find reference(element_count);
+    {
+        mapped_union_find sets(file.path(), element_count);
+        merge_randomly(sets, reference, element_count, gen);
+        sets.checkpoint();
+        merge_randomly(sets, reference, element_count, gen);
+    }
+
+    //Simulate a crash between linking and updating the sizes and the counter
+    patch_file(file.path(), 16, std::string(8, '\x7f'));
+    patch_file(file.path(), 32 + element_count*sizeof(int), std::string(element_count*sizeof(int), '\x01'));
+    mapped_union_find reopened(file.path());
+    expect_same_partition(reopened, reference, element_count);
+    for(int i = 0; i < element_count; i += 37) {
+        int expected_size = 0;
+        for(int j = 0; j < element_count; j++) {
+            expected_size += reference.same_set(i, j);
+        }
+        ASSERT_EQ(reopened.get_group_size(i), expected_size);
+    }
+}
+
+TEST(MappedUnionFind, RejectsForeignFiles) {
+    const temporary_file file("mapped_union_find_foreign");
+    {
+        mapped_union_find sets(file.path(), 100);
+        sets.merge(1, 2);
+        sets.checkpoint();
+    }
+    EXPECT_NO_THROW(mapped_union_find{file.path()});
+
+    patch_file(file.path(), 0, "NOTAFILE");
+    EXPECT_THROW(mapped_union_find{file.path()}, std::system_error);
+
+    {
+        mapped_union_find sets(file.path(), 100);
+    }
+    std::filesystem::resize_file(file.path(), 32 + 2*100*sizeof(int) + 4);
+    EXPECT_THROW(mapped_union_find{file.path()}, std::system_error);
+    std::filesystem::resize_file(file.path(), 32 + 2*99*sizeof(int));
+    EXPECT_THROW(mapped_union_find{file.path()}, std::system_error);
+    std::filesystem::resize_file(file.path(), 16);
+    EXPECT_THROW(mapped_union_find{file.path()}, std::system_error);
+
+    const temporary_file missing("mapped_union_find_missing");
+    std::filesystem::remove(missing.path());
+    EXPECT_THROW(mapped_union_find{missing.path()}, std::system_error);
+}
+
+template <typename weight_type>
+std::vector<weighted_edge<weight_type>> random_weighted_edges(const int vertex_count, const size_t edge_count, std::mt19937& gen, const weight_type low, const weight_type high) {
+    using distribution = std::conditional_t<std::is_floating_point_v<weight_type>, std::uniform_real_distribution<weight_type>, std::uniform_int_distribution<weight_type>>;
+    distribution weight(low, high);
+    std::vector<weighted_edge<weight_type>> edges(edge_count);
+    for(auto& edge : edges) {
+        edge.from = gen() % vertex_count;
+        edge.to = gen() % vertex_count;
+        edge.weight = weight(gen);
+    }
+    return edges;
+}
+
+template <typename weight_type>
+void check_radix_sort(const size_t edge_count, const unsigned thread_count, const weight_type low, const weight_type high) {
+    std::mt19937 gen(static_cast<unsigned>(edge_count));
+    std::vector<weighted_edge<weight_type>> edges = random_weighted_edges<weight_type>(1000, edge_count, gen, low, high);
+    std::vector<weighted_edge<weight_type>> expected = edges;
+    std::stable_sort(std::begin(expected), std::end(expected), [](const auto& first, const auto& second){
+        return first.weight < second.weight;
+    });
+    parallel_radix_sort(edges, thread_count);
+    for(size_t i = 0; i < edge_count; i++) {
+        //Stable, so equal weights keep their input order
+        ASSERT_EQ(edges[i].weight, expected[i].weight) << i;
+        ASSERT_EQ(edges[i].from, expected[i].from) << i;
+        ASSERT_EQ(edges[i].to, expected[i].to) << i;
+    }
+}
+
+TEST(Kruskal, RadixSortMatchesStableSort) {
+    for(const size_t edge_count : {0, 1, 100, 4096, 4097, 50'000}) {
+        for(const unsigned thread_count : {1u, 3u, 4u}) {
+            check_radix_sort<int>(edge_count, thread_count, -1'000'000'000, 1'000'000'000);
+            check_radix_sort<int>(edge_count, thread_count, -5, 5);
+            check_radix_sort<unsigned>(edge_count, thread_count, 0, 4'000'000'000u);
+            check_radix_sort<int16_t>(edge_count, thread_count, -30'000, 30'000);
+            check_radix_sort<int64_t>(edge_count, thread_count, -(int64_t{1} << 60), int64_t{1} << 60);
+            check_radix_sort<uint64_t>(edge_count, thread_count, 0, ~uint64_t{0});
+            check_radix_sort<float>(edge_count, thread_count, -1e6f, 1e6f);
+            check_radix_sort<double>(edge_count, thread_count, -1e150, 1e150);
+        }
+    }
+}
+
+// std::sort plus a union_find scan, the sorted weights of any minimum spanning forest are the same
+template <typename weight_type>
+std::vector<weight_type> reference_forest_weights(const int vertex_count, std::vector<weighted_edge<weight_type>> edges, const int target_groups, int& groups_count) {
+    std::sort(std::begin(edges), std::end(edges), [](const auto& first, const auto& second){
+        return first.weight < second.weight;
+    });
+    union_find sets(vertex_count);
+    std::vector<weight_type> weights;
+    for(const auto& edge : edges) {
+        if (sets.get_groups_count() <= target_groups) {
+            break;
+        }
+        if (!sets.merge(edge.from, edge.to)) {
+            weights.push_back(edge.weight);
+        }
+    }
+    groups_count = sets.get_groups_count();
+    return weights;
+}
+
+template <typename weight_type>
+std::vector<weight_type> sorted_weights(const std::vector<weighted_edge<weight_type>>& edges) {
+    std::vector<weight_type> weights;
+    for(const auto& edge : edges) {
+        weights.push_back(edge.weight);
+    }
+    std::sort(std::begin(weights), std::end(weights));
+    return weights;
+}
+
+template <typename weight_type>
+void check_kruskal(const int vertex_count, const size_t edge_count, const int target_groups, const weight_type low, const weight_type high) {
+    std::mt19937 gen(vertex_count + static_cast<unsigned>(edge_count) + target_groups);
+    const std::vector<weighted_edge<weight_type>> edges = random_weighted_edges<weight_type>(vertex_count, edge_count, gen, low, high);
+    int expected_groups = 0;
+    const std::vector<weight_type> expected = reference_forest_weights(vertex_count, edges, target_groups, expected_groups);
+
+    for(const unsigned thread_count : {1u, 4u}) {
+        union_find sets(vertex_count);
+        const auto selected = kruskal(vertex_count, edges, sets, target_groups, thread_count);
+        ASSERT_EQ(sorted_weights(selected), expected);
+        ASSERT_EQ(sets.get_groups_count(), expected_groups);
+
+        //Small base size forces the partitioning recursion, the default one sorts everything at once
+        for(const size_t base_size : {size_t{16}, size_t{1} << 20}) {
+            std::vector<weighted_edge<weight_type>> filtered_edges = edges;
+            union_find filtered_sets(vertex_count);
+            const auto filtered = filter_kruskal(vertex_count, filtered_edges, filtered_sets, target_groups, base_size, thread_count);
+            ASSERT_EQ(sorted_weights(filtered), expected);
+            ASSERT_EQ(filtered_sets.get_groups_count(), expected_groups);
+            for(const auto& edge : filtered) {
+                ASSERT_EQ(filtered_sets.find(edge.from), filtered_sets.find(edge.to));
+            }
+        }
+    }
+}
+
+TEST(Kruskal, MatchesSortAndScan) {
+    for(const int target_groups : {1, 5, 300}) {
+        check_kruskal<int>(1000, 20'000, target_groups, -1000, 1000);
+        check_kruskal<int>(1000, 20'000, target_groups, -3, 3);
+        check_kruskal<unsigned>(1000, 20'000, target_groups, 0, 100'000);
+        check_kruskal<int64_t>(2000, 3000, target_groups, -(int64_t{1} << 50), int64_t{1} << 50);
+        check_kruskal<float>(1000, 20'000, target_groups, -1.0f, 1.0f);
+        check_kruskal<double>(5000, 8000, target_groups, -1e9, 1e9);
+        check_kruskal<double>(50, 300, target_groups, -1.0, 0.0);
+    }
+}
+
+TEST(Kruskal, SingleLinkageClustering) {
+    //Two tight clusters joined by one heavy edge
+    std::vector<weighted_edge<int>> edges{{0, 1, 1}, {1, 2, 2}, {3, 4, 1}, {4, 5, -1}, {2, 3, 100}, {0, 2, 3}};
+    union_find clusters = single_linkage_clustering(6, edges, 2);
+    EXPECT_EQ(clusters.get_groups_count(), 2);
+    EXPECT_EQ(clusters.find(0), clusters.find(2));
+    EXPECT_EQ(clusters.find(3), clusters.find(5));
+    EXPECT_NE(clusters.find(0), clusters.find(3));
+
+    const auto forest = minimum_spanning_forest(7, edges);
+    EXPECT_EQ(sorted_weights(forest), (std::vector<int>{-1, 1, 1, 2, 100}));
+}
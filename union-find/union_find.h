@@ -2,16 +2,57 @@
 
 #include <algorithm>
 #include <numeric>
+#include <span>
+#include <thread>
+#include <utility>
 #include <vector>
 
+// Dense relabelling of a partition, component c has members[offsets[c]] .. members[offsets[c+1]-1]
+struct component_index {
+    std::vector<int> labels;
+    std::vector<int> offsets;
+    std::vector<int> members;
+};
+
+// In-place exclusive prefix sum, blocks are summed in parallel and then offset by the sums of preceding blocks
+inline void parallel_exclusive_scan(std::vector<int>& values, unsigned thread_count = std::thread::hardware_concurrency()) {
+    constexpr size_t min_block = 1 << 16;
+    const size_t size = values.size();
+    thread_count = static_cast<unsigned>(std::clamp<size_t>(size/min_block, 1, std::max(1u, thread_count)));
+    const size_t block = (size+thread_count-1)/thread_count;
+    std::vector<int> block_sums(thread_count+1, 0);
+
+    auto run_parallel = [thread_count](auto&& work) {
+        std::vector<std::thread> threads;
+        for(unsigned t = 1; t < thread_count; t++) {
+            threads.emplace_back(work, t);
+        }
+        work(0);
+        for(auto& thread : threads) {
+            thread.join();
+        }
+    };
+
+    run_parallel([&](const unsigned t){
+        const auto begin = std::begin(values) + std::min(size, t*block);
+        const auto end = std::begin(values) + std::min(size, (t+1)*block);
+        block_sums[t+1] = std::accumulate(begin, end, 0);
+    });
+    std::partial_sum(std::begin(block_sums), std::end(block_sums), std::begin(block_sums));
+    run_parallel([&](const unsigned t){
+        const auto begin = std::begin(values) + std::min(size, t*block);
+        const auto end = std::begin(values) + std::min(size, (t+1)*block);
+        std::exclusive_scan(begin, end, begin, block_sums[t]);
+    });
+}
+
 class union_find {
     std::vector<int> roots;
     std::vector<int> sizes;
     int groups_count;
 
 public:  
-    union_find(const int max_count) : roots(max_count), sizes(max_count), groups_count(max_count) {
-        std::fill(std::begin(roots), std::end(roots), 1);
+    union_find(const int max_count) : roots(max_count), sizes(max_count, 1), groups_count(max_count) {
         std::iota(std::begin(roots), std::end(roots), 0);
     }
  
@@ -22,13 +63,7 @@ public:
             root_idx = roots[root_idx];
         }
 
-        //Reconnect all elements to root
-        while (idx != root_idx) {
-            const int next_idx = roots[idx];
-            roots[idx] = root_idx;
-            idx = next_idx;
-        }
-
+        compress(idx, root_idx);
         return root_idx;
     }
  
@@ -55,4 +90,124 @@ public:
     int get_groups_count() const noexcept {
         return groups_count;
     }
+
+    // Batched find - independent lookups are interleaved in groups, so the cache misses of
+    // the whole group overlap instead of being paid one after another
+    void find_many(std::span<const int> indices, std::span<int> results) noexcept {
+        for(size_t begin = 0; begin < indices.size(); begin += batch_size) {
+            const size_t count = std::min(batch_size, indices.size()-begin);
+            find_batch(&indices[begin], &results[begin], count);
+        }
+    }
+
+    void same_set_many(std::span<const std::pair<int, int>> pairs, std::span<bool> results) noexcept {
+        int indices[batch_size];
+        int found[batch_size];
+        for(size_t begin = 0; begin < pairs.size(); begin += batch_size/2) {
+            const size_t count = std::min(batch_size/2, pairs.size()-begin);
+            for(size_t i = 0; i < count; i++) {
+                indices[2*i] = pairs[begin+i].first;
+                indices[2*i+1] = pairs[begin+i].second;
+            }
+            find_batch(indices, found, 2*count);
+            for(size_t i = 0; i < count; i++) {
+                results[begin+i] = found[2*i] == found[2*i+1];
+            }
+        }
+    }
+
+    // Batched merge, returns the number of pairs that joined two different groups
+    int merge_many(std::span<const std::pair<int, int>> pairs) noexcept {
+        int indices[batch_size];
+        int found[batch_size];
+        int merged = 0;
+        for(size_t begin = 0; begin < pairs.size(); begin += batch_size/2) {
+            const size_t count = std::min(batch_size/2, pairs.size()-begin);
+            for(size_t i = 0; i < count; i++) {
+                indices[2*i] = pairs[begin+i].first;
+                indices[2*i+1] = pairs[begin+i].second;
+            }
+            find_batch(indices, found, 2*count);
+            //Roots found for the batch may have been linked by an earlier merge of the same batch, find on them stays in cache
+            for(size_t i = 0; i < count; i++) {
+                merged += !merge(found[2*i], found[2*i+1]);
+            }
+        }
+        return merged;
+    }
+
+    // Connects every element directly to its root and returns dense labels 0..k-1 of the
+    // components, numbered in the order of their smallest elements
+    std::vector<int> compact() {
+        std::vector<int> labels(roots.size(), -1);
+        int next_label = 0;
+        for(size_t i = 0; i < roots.size(); i++) {
+            const int root_idx = find(static_cast<int>(i));
+            //A root is labelled when its first member is seen, its own slot is not read before that
+            if (labels[root_idx] == -1) {
+                labels[root_idx] = next_label++;
+            }
+            labels[i] = labels[root_idx];
+        }
+        return labels;
+    }
+
+    // compact() plus a CSR index listing members of every component in increasing order
+    component_index compact_with_members(const unsigned thread_count = std::thread::hardware_concurrency()) {
+        component_index index;
+        index.labels = compact();
+        index.offsets.assign(groups_count+1, 0);
+        for(const int label : index.labels) {
+            index.offsets[label]++;
+        }
+        parallel_exclusive_scan(index.offsets, thread_count);
+
+        index.members.resize(roots.size());
+        std::vector<int> positions(std::begin(index.offsets), std::end(index.offsets)-1);
+        for(size_t i = 0; i < roots.size(); i++) {
+            index.members[positions[index.labels[i]]++] = static_cast<int>(i);
+        }
+        return index;
+    }
+
+private:
+    static constexpr size_t batch_size = 32;
+
+    //Reconnect all elements to root
+    void compress(int idx, const int root_idx) noexcept {
+        while (idx != root_idx) {
+            const int next_idx = roots[idx];
+            roots[idx] = root_idx;
+            idx = next_idx;
+        }
+    }
+
+    void find_batch(const int* indices, int* results, const size_t count) noexcept {
+        for(size_t i = 0; i < count; i++) {
+            results[i] = indices[i];
+            __builtin_prefetch(&roots[indices[i]]);
+        }
+
+        //Every round moves each unfinished lookup one level up and prefetches its next parent
+        size_t active[batch_size];
+        size_t active_count = count;
+        std::iota(active, active+count, size_t{0});
+        while(active_count) {
+            size_t still_active = 0;
+            for(size_t k = 0; k < active_count; k++) {
+                const size_t i = active[k];
+                const int parent = roots[results[i]];
+                if (parent != results[i]) {
+                    results[i] = parent;
+                    __builtin_prefetch(&roots[parent]);
+                    active[still_active++] = i;
+                }
+            }
+            active_count = still_active;
+        }
+
+        for(size_t i = 0; i < count; i++) {
+            compress(indices[i], results[i]);
+        }
+    }
 };
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Abelian groups usable as offsets of weighted_union_find. A group supplies the value type,
+// the neutral element, the group operation and the inverse element.
+template <typename T>
+struct additive_group {
+    using value_type = T;
+    static constexpr T identity() noexcept { return T{0}; }
+    static constexpr T combine(const T first, const T second) noexcept { return first + second; }
+    static constexpr T inverse(const T value) noexcept { return -value; }
+};
+
+template <typename T>
+struct xor_group {
+    using value_type = T;
+    static constexpr T identity() noexcept { return T{0}; }
+    static constexpr T combine(const T first, const T second) noexcept { return first ^ second; }
+    static constexpr T inverse(const T value) noexcept { return value; }
+};
+
+// Outcome of weighted_union_find::add_constraint
+enum class constraint_result {
+    merged,       // the elements were in different groups, which are now joined
+    redundant,    // the elements were already connected with the same difference
+    contradiction // the elements were already connected with a different difference
+};
+
+// Union-find where every element has a potential and add_constraint joins groups by constraints
+// of the form "potential(second) - potential(first) = offset". Each element stores the offset to its parent,
+// path compression rewrites it to the offset to the root.
+template <typename Group = additive_group<long long>>
+class weighted_union_find {
+public:
+    using value_type = typename Group::value_type;
+
+private:
+    std::vector<int> roots;
+    std::vector<int> sizes;
+    std::vector<value_type> offsets;
+    int groups_count;
+
+public:
+    weighted_union_find(const int max_count) : roots(max_count), sizes(max_count, 1), offsets(max_count, Group::identity()), groups_count(max_count) {
+        std::iota(std::begin(roots), std::end(roots), 0);
+    }
+
+    int find(int idx) noexcept {
+        //Find root index and the offset of idx from it
+        int root_idx = idx;
+        value_type total = Group::identity();
+        while(root_idx != roots[root_idx]) {
+            total = Group::combine(total, offsets[root_idx]);
+            root_idx = roots[root_idx];
+        }
+
+        //Reconnect all elements to root, offset of the next element is the remainder of the path
+        while (idx != root_idx) {
+            const int next_idx = roots[idx];
+            const value_type next_total = Group::combine(total, Group::inverse(offsets[idx]));
+            roots[idx] = root_idx;
+            offsets[idx] = total;
+            total = next_total;
+            idx = next_idx;
+        }
+
+        return root_idx;
+    }
+
+    // Potential of idx relative to the root of its group
+    value_type potential(const int idx) noexcept {
+        find(idx);
+        return offsets[idx];
+    }
+
+    // Adds constraint potential(second) - potential(first) = offset. Connected elements are
+    // left untouched, the result tells whether the constraint agrees with their difference.
+    constraint_result add_constraint(const int first, const int second, const value_type offset) noexcept {
+        int first_idx = find(first);
+        int second_idx = find(second);
+        const value_type first_potential = offsets[first];
+        const value_type second_potential = offsets[second];
+
+        if (first_idx == second_idx) {
+            if (Group::combine(second_potential, Group::inverse(first_potential)) == offset) {
+                return constraint_result::redundant;
+            }
+            return constraint_result::contradiction;
+        }
+
+        groups_count--;
+
+        //Offset of the second root relative to the first root
+        value_type root_offset = Group::combine(Group::combine(first_potential, offset), Group::inverse(second_potential));
+        if(sizes[first_idx] > sizes[second_idx]){
+            std::swap(first_idx, second_idx);
+            root_offset = Group::inverse(root_offset);
+        }
+
+        roots[first_idx] = second_idx;
+        offsets[first_idx] = Group::inverse(root_offset);
+        sizes[second_idx] += sizes[first_idx];
+
+        return constraint_result::merged;
+    }
+
+    bool same_set(const int first, const int second) noexcept {
+        return find(first) == find(second);
+    }
+
+    // potential(second) - potential(first), empty when the elements are not connected
+    std::optional<value_type> diff(const int first, const int second) noexcept {
+        if (!same_set(first, second)) {
+            return std::nullopt;
+        }
+        return Group::combine(offsets[second], Group::inverse(offsets[first]));
+    }
+
+    int get_groups_count() const noexcept {
+        return groups_count;
+    }
+};